@@ -0,0 +1,186 @@
+//    Copyright (c) 2018 Will Wray https://keybase.io/willwray
+//
+//   Distributed under the Boost Software License, Version 1.0.
+//          (http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include "array_nd_ref.hpp"
+
+/*
+   "array_nd.hpp"
+    ^^^^^^^^^^^^^
+    This header defines array_nd::array, an owning container for a
+    C-array of any rank, heap allocated at a chosen alignment.
+
+  Usage:
+      array_nd::array<float[512][512], array_nd::page_align> m;
+      array_nd_ref<float[512][512]> r = m; // converts to a view
+
+  array_nd::array<A, Align>
+    Owns one A array, aligned to Align bytes; 64 (cache line) default.
+    Think fixed-size std::vector<A> of size 1, with array interface.
+    (Named array in namespace array_nd as array_nd names the namespace.)
+
+  Alignment:
+    Align is a power of two, at least alignof(element_type).
+    cache_line_align  64       SIMD aligned loads, no false sharing
+    page_align        4096     page granular, e.g. for mprotect, O_DIRECT
+    huge_page_align   2 MiB    also requests transparent huge page backing
+                               (madvise MADV_HUGEPAGE, on Linux only)
+
+  Semantics:
+    Deep copy and compare, like std::array.
+    Move steals the allocation; the moved-from array has no storage
+    and may only be assigned to, copied or destroyed; its copies have
+    no storage either.
+    Converts implicitly to array_nd_ref<A> and array_nd_ref<A const>.
+*/
+namespace array_nd
+{
+inline constexpr size_t cache_line_align = 64;
+inline constexpr size_t page_align = 4096;
+inline constexpr size_t huge_page_align = size_t{2} << 20;
+
+template <typename A, size_t Align = cache_line_align>
+requires std::is_array_v<A> && std::extent_v<A> != 0
+      && is_not_cvref<A> && !std::is_const_v<std::remove_all_extents_t<A>>
+      && (Align & (Align - 1)) == 0
+      && Align >= alignof(std::remove_all_extents_t<A>)
+class array
+{
+  public:
+    using array_type      = A;
+    using element_type    = std::remove_all_extents_t<A>;
+    using value_type      = element_type;
+    using size_type       = size_t;
+    using difference_type = ptrdiff_t;
+    using iterator        = typename array_nd_ref<A>::iterator;
+    using const_iterator  = typename array_nd_ref<A>::const_iterator;
+
+    static constexpr size_t alignment = Align;
+    static constexpr unsigned rank = std::rank_v<A>;
+    static constexpr size_t extent = std::extent_v<A>;
+
+    // Elements are value-initialized
+    array() : p{allocate()}
+    {
+        try {
+            std::uninitialized_value_construct_n(first(), array_size<A>);
+        } catch (...) { deallocate(p); throw; }
+    }
+    // Deep copy from C-array
+    array(A const& init) : p{allocate()} { construct_from(init); }
+
+    array(array const& o) : p{o.p ? allocate() : nullptr} {
+        if (p)
+            construct_from(*o.p);
+    }
+    array(array&& o) noexcept : p{std::exchange(o.p, nullptr)} {}
+
+    array& operator=(array const& o)
+    {
+        if (!o.p)
+            array(o).swap(*this);
+        else if (this != &o)
+            *this = *o.p;
+        return *this;
+    }
+    array& operator=(array&& o) noexcept
+    {
+        array(std::move(o)).swap(*this);
+        return *this;
+    }
+    // Deep copy assign from C-array
+    array& operator=(A const& rhs)
+    {
+        if (p)
+            ref() = rhs;
+        else
+            array(rhs).swap(*this);
+        return *this;
+    }
+    ~array() { if (p) { std::destroy_n(first(), array_size<A>);
+                        deallocate(p); } }
+
+    operator array_nd_ref<A>() noexcept { return ref(); }
+    operator array_nd_ref<A const>() const noexcept {
+        return ref();
+    }
+    array_nd_ref<A> ref() noexcept { return {*p}; }
+    array_nd_ref<A const> ref() const noexcept { return {*p}; }
+
+    // data() returns a ref to the whole, Align-aligned, A array
+    A& data() noexcept { return *std::assume_aligned<Align>(p); }
+    A const& data() const noexcept { return *std::assume_aligned<Align>(p); }
+
+    constexpr size_t size() const noexcept { return extent; }
+    constexpr bool empty() const noexcept { return false; }
+
+    decltype(auto) operator[](size_t i) noexcept { return data()[i]; }
+    decltype(auto) operator[](size_t i) const noexcept { return data()[i]; }
+    decltype(auto) operator()(size_t i) { return ref()(i); }
+    decltype(auto) operator()(size_t i) const { return ref()(i); }
+
+    iterator begin() noexcept { return ref().begin(); }
+    const_iterator begin() const noexcept { return ref().begin(); }
+    iterator end() noexcept { return ref().end(); }
+    const_iterator end() const noexcept { return ref().end(); }
+    auto elements() noexcept { return ref().elements(); }
+    auto elements() const noexcept { return ref().elements(); }
+
+    void fill(value_type const& v) { ref().fill(v); }
+
+    // Shallow swap; exchanges allocations
+    void swap(array& o) noexcept { std::swap(p, o.p); }
+    friend void swap(array& x, array& y) noexcept { x.swap(y); }
+
+    friend bool operator==(array const& x, array const& y) {
+        return x.ref() == y.ref();
+    }
+    friend auto operator<=>(array const& x, array const& y) {
+        return x.ref() <=> y.ref();
+    }
+
+  private:
+    // Allocation size is rounded up to whole huge pages when requested,
+    // so that the madvise hint covers the whole allocation.
+    static constexpr size_t bytes = Align >= huge_page_align
+                  ? (sizeof(A) + huge_page_align-1) & ~(huge_page_align-1)
+                  : sizeof(A);
+
+    static A* allocate()
+    {
+        void* raw = ::operator new(bytes, std::align_val_t{Align});
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        if constexpr (Align >= huge_page_align)
+            ::madvise(raw, bytes, MADV_HUGEPAGE); // hint only; may fail
+#endif
+        return std::launder(static_cast<A*>(raw));
+    }
+    static void deallocate(A* a) noexcept
+    {
+        ::operator delete(static_cast<void*>(a), bytes,
+                          std::align_val_t{Align});
+    }
+    element_type* first() noexcept { return impl::flat(p); }
+
+    void construct_from(A const& init)
+    {
+        try {
+            std::uninitialized_copy_n(impl::flat(&init), array_size<A>,
+                                      first());
+        } catch (...) { deallocate(p); throw; }
+    }
+
+    A* p;
+};
+}
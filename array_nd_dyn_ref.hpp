@@ -0,0 +1,389 @@
+//    Copyright (c) 2018 Will Wray https://keybase.io/willwray
+//
+//   Distributed under the Boost Software License, Version 1.0.
+//          (http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <span>
+
+#include "array_nd_ref.hpp"
+
+/*
+   "array_nd_dyn_ref.hpp"
+    ^^^^^^^^^^^^^^^^^^^^
+    This header defines array_nd_dyn_ref, a sibling of array_nd_ref for
+    row-major multidimensional arrays with any mix of static extents and
+    dynamic, runtime, extents.
+
+  Usage:
+      std::vector<float> v(rows * 64);
+      auto g = array_nd_dyn_ref<float, array_nd::dyn, 64>{v.data(), rows};
+      g(2)[5] = 1;     // g(2) is array_nd_ref<float[64]>, static extent
+      g.fill(0);
+
+  array_nd_dyn_ref<T, X...>
+    Refers to T elements laid out as a C-array T[X0][X1]...
+    with each extent X either static or array_nd::dyn.
+    Holds a T* plus only the dynamic extents; static extents are free.
+
+  Interface, as array_nd_ref:
+    operator[], operator() index the outermost dimension:
+      rank 1: element T&
+      rank>1: subarray view - array_nd_ref<T[...]> for an all-static
+              tail, (and [] gives builtin subarray ref), else dyn ref.
+    fill, deep copy assign, comparisons (==, <=> and rewrites).
+    Shallow copy construct and copy assign from same type; assignment
+    from C-array or array_nd_ref is deep; assign() deep copies from any
+    view of the same value_type and rank.
+    Shape mismatch in a deep copy throws std::length_error.
+    Comparisons compare extents first, then elements as-if flat.
+    elements() is a std::span over all elements.
+
+  Const member functions give non-const element access, as std::span;
+  constness of elements is in T.
+  Subarray views for static tails reinterpret the flat T* as pointer to
+  C subarray, so are not constant expressions.
+*/
+namespace array_nd
+{
+// dyn marks a dynamic extent, given at runtime
+inline constexpr size_t dyn = std::dynamic_extent;
+}
+
+template <typename T, size_t... X>
+requires sizeof...(X) != 0 && ((X != 0) && ...)
+      && !std::is_array_v<T> && !std::is_reference_v<T>
+struct array_nd_dyn_ref;
+
+namespace impl
+{
+// array_of_t<T,X...> builtin array type T[X0][X1]...
+template <typename T, size_t... X>
+struct array_of { using type = T; };
+template <typename T, size_t X0, size_t... X>
+struct array_of<T, X0, X...>
+{
+    using type = typename array_of<T, X...>::type[X0];
+};
+template <typename T, size_t... X>
+using array_of_t = typename array_of<T, X...>::type;
+
+// dyn_compatible<A,X...> true if static extents X match those of A
+template <typename A, size_t... X>
+constexpr bool dyn_compatible() noexcept
+{
+    if constexpr (std::rank_v<A> != sizeof...(X))
+        return false;
+    else
+        return [&]<size_t... D>(std::index_sequence<D...>) {
+            return ((X == array_nd::dyn || X == std::extent_v<A,D>) && ...);
+        }(std::make_index_sequence<sizeof...(X)>{});
+}
+
+// dyn_extents<N> storage for N dynamic extents; an empty class if N == 0
+struct no_dyn_extents {};
+template <unsigned N>
+using dyn_extents = std::conditional_t<N == 0, no_dyn_extents,
+                                               std::array<size_t, N>>;
+
+// dyn_tail<T,X0,X...> the view type of a subarray of dyn_ref<T,X0,X...>
+//   all-static tail: array_nd_ref<T[X]...>, else array_nd_dyn_ref<T,X...>
+template <bool is_static, typename T, size_t... X>
+struct dyn_tail_view { using type = array_nd_dyn_ref<T, X...>; };
+template <typename T, size_t... X>
+struct dyn_tail_view<true, T, X...>
+{
+    using type = array_nd_ref<array_of_t<T, X...>>;
+};
+template <typename T, size_t X0, size_t... X>
+struct dyn_tail
+{
+    static constexpr bool is_static = ((X != array_nd::dyn) && ...);
+    using type = typename dyn_tail_view<is_static, T, X...>::type;
+};
+
+// dyn_view(a) all-dynamic array_nd_dyn_ref view of C-array or array_nd_ref
+template <typename A, typename T, size_t... D>
+constexpr auto dyn_view(T* p, std::index_sequence<D...>)
+{
+    return array_nd_dyn_ref<T const, (void(D), array_nd::dyn)...>{
+            p, std::extent_v<A,D>...};
+}
+template <typename A>
+requires std::is_array_v<A>
+constexpr auto dyn_view(A const& a)
+{
+    return dyn_view<A>(flat(a), std::make_index_sequence<std::rank_v<A>>{});
+}
+template <typename A>
+constexpr auto dyn_view(array_nd_ref<A> r)
+{
+    return dyn_view<A>(flat(r.a), std::make_index_sequence<std::rank_v<A>>{});
+}
+}
+
+template <typename T, size_t... X>
+requires sizeof...(X) != 0 && ((X != 0) && ...)
+      && !std::is_array_v<T> && !std::is_reference_v<T>
+struct array_nd_dyn_ref
+{
+    using type            = array_nd_dyn_ref;
+    using element_type    = T;
+    using value_type      = std::remove_cv_t<T>;
+    using index_type      = ptrdiff_t;
+    using difference_type = ptrdiff_t;
+    using size_type       = size_t;
+    using pointer         = T*;
+    using reference       = T&;
+
+    static constexpr unsigned rank = sizeof...(X);
+    static constexpr unsigned rank_dynamic = ((X == array_nd::dyn) + ...);
+    static constexpr std::array<size_t, rank> static_extents{X...};
+
+    using dynamic_extents_type = impl::dyn_extents<rank_dynamic>;
+
+    pointer p;
+    [[no_unique_address]] dynamic_extents_type dynamic_extents;
+
+    // Construct from pointer to first element plus the dynamic extents
+    template <typename... I>
+    requires (sizeof...(I) == rank_dynamic) && (std::is_integral_v<I> && ...)
+    constexpr array_nd_dyn_ref(pointer p, I... dyn_extents) noexcept
+        : p{p}, dynamic_extents{static_cast<size_t>(dyn_extents)...} {}
+
+    constexpr array_nd_dyn_ref(pointer p,
+                               dynamic_extents_type const& dx) noexcept
+        : p{p}, dynamic_extents{dx} {}
+
+    // Construct from C-array, or array_nd_ref, of compatible extents
+    template <typename A>
+    requires std::is_array_v<A> && impl::dyn_compatible<A, X...>()
+          && std::is_convertible_v<std::remove_all_extents_t<A>*, T*>
+    constexpr array_nd_dyn_ref(A& a) noexcept
+        : p{impl::flat(a)}, dynamic_extents{extents_of<A>()} {}
+
+    template <typename A>
+    requires impl::dyn_compatible<A, X...>()
+          && std::is_convertible_v<std::remove_all_extents_t<A>*, T*>
+    constexpr array_nd_dyn_ref(array_nd_ref<A> a) noexcept
+        : p{impl::flat(a.a)}, dynamic_extents{extents_of<A>()} {}
+
+    // extent(d) extent of dimension d; size() is the outermost extent
+    constexpr size_t extent(unsigned d) const noexcept
+    {
+        if constexpr (rank_dynamic != 0)
+            if (static_extents[d] == array_nd::dyn)
+                return dynamic_extents[dynamic_index(d)];
+        return static_extents[d];
+    }
+    constexpr size_t size() const noexcept { return extent(0); }
+    constexpr size_t max_size() const noexcept { return size(); }
+    constexpr bool empty() const noexcept { return false; }
+
+    // stride(d) elements spanned by a unit step of index d
+    constexpr size_t stride(unsigned d) const noexcept
+    {
+        size_t s = 1;
+        for (unsigned k = d+1; k < rank; ++k)
+            s *= extent(k);
+        return s;
+    }
+    // size_flat() the total number of elements
+    constexpr size_t size_flat() const noexcept { return size()*stride(0); }
+
+    constexpr decltype(auto) operator[](size_t i) const;
+    constexpr decltype(auto) operator()(size_t i) const;
+    constexpr decltype(auto) at(size_t i) const;
+
+    constexpr decltype(auto) front() const { return operator[](0); }
+    constexpr decltype(auto) back() const { return operator[](size()-1); }
+
+    constexpr std::span<T> elements() const noexcept {
+        return {p, size_flat()};
+    }
+    constexpr pointer data() const noexcept { return p; }
+
+    constexpr void fill(value_type const& e) const
+    {
+        std::fill_n(p, size_flat(), e);
+    }
+
+    // deep copy from any view of same value_type and rank
+    template <typename S>
+    constexpr void assign(S const& src) const;
+
+    // deep copy of C-array or array_nd_ref rhs to referred-to array
+    template <typename A>
+    requires std::is_array_v<A> && (std::rank_v<A> == rank)
+    constexpr type operator=(A const& rhs) { assign(rhs); return *this; }
+    template <typename A>
+    requires (std::rank_v<A> == rank)
+    constexpr type operator=(array_nd_ref<A> rhs) {
+        assign(rhs); return *this;
+    }
+
+    // Member comparisons for array rhs call non-member comparisons
+    template <typename A>
+    requires std::is_array_v<A> && (std::rank_v<A> == rank)
+    constexpr bool operator==(A const& y) const {
+              return *this == impl::dyn_view(y);
+    }
+    template <typename A>
+    requires std::is_array_v<A> && (std::rank_v<A> == rank)
+    constexpr auto operator<=>(A const& y) const {
+              return *this <=> impl::dyn_view(y);
+    }
+
+    // Shallow swap, as array_nd_ref
+    constexpr void swap(array_nd_dyn_ref& b) noexcept {
+        std::swap(p, b.p);
+        std::swap(dynamic_extents, b.dynamic_extents);
+    }
+
+    // index into dynamic_extents of dynamic dimension d
+    static constexpr unsigned dynamic_index(unsigned d) noexcept
+    {
+        unsigned n = 0;
+        for (unsigned k = 0; k != d; ++k)
+            n += static_extents[k] == array_nd::dyn;
+        return n;
+    }
+
+  private:
+    template <typename A>
+    static constexpr auto extents_of() noexcept
+    {
+        dynamic_extents_type dx{};
+        if constexpr (rank_dynamic != 0)
+        {
+            auto ax = [&]<size_t... D>(std::index_sequence<D...>) {
+                return std::array<size_t, rank>{std::extent_v<A,D>...};
+            }(std::make_index_sequence<rank>{});
+            for (unsigned d = 0; d != rank; ++d)
+                if (static_extents[d] == array_nd::dyn)
+                    dx[dynamic_index(d)] = ax[d];
+        }
+        return dx;
+    }
+
+    // sub(i) subarray view for rank > 1
+    constexpr auto sub(size_t i) const;
+};
+
+template <typename T, size_t... X>
+requires sizeof...(X) != 0 && ((X != 0) && ...)
+      && !std::is_array_v<T> && !std::is_reference_v<T>
+constexpr auto array_nd_dyn_ref<T,X...>::sub(size_t i) const
+{
+    using sub_t = typename impl::dyn_tail<T, X...>::type;
+    pointer q = p + i*stride(0);
+    if constexpr (impl::dyn_tail<T, X...>::is_static)
+        return sub_t{reinterpret_cast<typename sub_t::pointer>(q)};
+    else
+    {
+        constexpr unsigned skip = static_extents[0] == array_nd::dyn;
+        typename sub_t::dynamic_extents_type dx{};
+        std::copy_n(dynamic_extents.begin() + skip, dx.size(), dx.begin());
+        return sub_t{q, dx};
+    }
+}
+
+template <typename T, size_t... X>
+requires sizeof...(X) != 0 && ((X != 0) && ...)
+      && !std::is_array_v<T> && !std::is_reference_v<T>
+constexpr decltype(auto) array_nd_dyn_ref<T,X...>::operator()(size_t i) const
+{
+    if constexpr (rank == 1)
+        return p[i];
+    else
+        return sub(i);
+}
+
+template <typename T, size_t... X>
+requires sizeof...(X) != 0 && ((X != 0) && ...)
+      && !std::is_array_v<T> && !std::is_reference_v<T>
+constexpr decltype(auto) array_nd_dyn_ref<T,X...>::operator[](size_t i) const
+{
+    if constexpr (rank == 1)
+        return p[i];
+    else if constexpr (impl::dyn_tail<T, X...>::is_static)
+        return *reinterpret_cast<typename decltype(sub(i))::cv_array_type*>(
+                                                       p + i*stride(0));
+    else
+        return sub(i);
+}
+
+template <typename T, size_t... X>
+requires sizeof...(X) != 0 && ((X != 0) && ...)
+      && !std::is_array_v<T> && !std::is_reference_v<T>
+constexpr decltype(auto) array_nd_dyn_ref<T,X...>::at(size_t i) const
+{
+    if (i >= size())
+        throw(std::out_of_range("array_nd_dyn_ref::at"));
+    return operator[](i);
+}
+
+template <typename T, size_t... X>
+requires sizeof...(X) != 0 && ((X != 0) && ...)
+      && !std::is_array_v<T> && !std::is_reference_v<T>
+template <typename S>
+constexpr void array_nd_dyn_ref<T,X...>::assign(S const& src) const
+{
+    auto from = [&]{
+        if constexpr (std::is_array_v<S> || is_array_nd_ref_v<S>)
+            return impl::dyn_view(src);
+        else
+            return src;
+    }();
+    static_assert(decltype(from)::rank == rank,
+                  "array_nd_dyn_ref::assign rank mismatch");
+    for (unsigned d = 0; d != rank; ++d)
+        if (from.extent(d) != extent(d))
+            throw(std::length_error("array_nd_dyn_ref::assign"));
+    std::copy_n(from.p, size_flat(), p);
+}
+
+template <typename T, size_t... X, typename U, size_t... Y>
+requires (sizeof...(X) == sizeof...(Y))
+      && std::is_same_v<std::remove_cv_t<T>, std::remove_cv_t<U>>
+constexpr bool
+operator==( array_nd_dyn_ref<T,X...> x, array_nd_dyn_ref<U,Y...> y)
+{
+    for (unsigned d = 0; d != x.rank; ++d)
+        if (x.extent(d) != y.extent(d))
+            return false;
+    return impl::flat_equal(x.p, y.p, x.size_flat());
+}
+
+// Extents compare first, then elements lexicographically as-if flat
+template <typename T, size_t... X, typename U, size_t... Y>
+requires (sizeof...(X) == sizeof...(Y))
+      && std::is_same_v<std::remove_cv_t<T>, std::remove_cv_t<U>>
+constexpr auto
+operator<=>( array_nd_dyn_ref<T,X...> x, array_nd_dyn_ref<U,Y...> y)
+   -> impl::synth_three_way_result<std::remove_cv_t<T>>
+{
+    for (unsigned d = 0; d != x.rank; ++d)
+        if (x.extent(d) != y.extent(d))
+            return x.extent(d) <=> y.extent(d);
+    size_t const n = x.size_flat();
+    size_t i = 0;
+    if constexpr (impl::is_bitwise_comparable<std::remove_cv_t<T>>)
+        if (!std::is_constant_evaluated() && impl::flat_equal(x.p, y.p, n))
+            i = n;
+    for (; i != n; ++i)
+        if (x.p[i] != y.p[i])
+            return impl::synth_three_way{}(x.p[i], y.p[i]);
+    return std::strong_ordering::equal;
+}
+
+template <typename T, size_t... X>
+constexpr void
+swap( array_nd_dyn_ref<T,X...>& x, array_nd_dyn_ref<T,X...>& y) noexcept
+{
+    x.swap(y);
+}
+
+template <typename T, size_t... X>
+constexpr size_t size( array_nd_dyn_ref<T,X...> a) { return a.size(); }
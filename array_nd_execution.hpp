@@ -0,0 +1,160 @@
+//    Copyright (c) 2018 Will Wray https://keybase.io/willwray
+//
+//   Distributed under the Boost Software License, Version 1.0.
+//          (http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <atomic>
+#include <execution>
+#include <numeric>
+#include <vector>
+
+#include "array_nd_ref.hpp"
+
+/*
+   "array_nd_execution.hpp"
+    ^^^^^^^^^^^^^^^^^^^^^^
+    Overloads of array_nd_ref fill, deep copy, deep swap and equality
+    that take a C++17 execution policy, std::execution::par etc.
+
+  Usage:
+      static double snap[1024][1024][256], live[1024][1024][256];
+      array_nd::copy(std::execution::par, array_nd_ref{live},
+                                          array_nd_ref{snap});
+
+  Functions, in namespace array_nd:
+    fill(policy, a, v)      as a.fill(v)
+    copy(policy, src, dst)  as dst = src, deep copy
+    swap(policy, a, b)      as a.swap(b) for C-array b, deep swap
+    equal(policy, x, y)     as x == y
+
+  The outermost extent is split into chunks of whole subarrays, each
+  at least min_chunk_bytes, which run as tasks under the policy.
+  Within a chunk the flat fast paths of array_nd_ref are used
+  (memset / memmove / memcmp for trivial element types).
+  An array smaller than min_chunk_bytes, or of outer extent 1, is
+  processed as a single chunk.
+
+  With libstdc++, parallel policies need TBB (link -ltbb); without
+  the TBB headers the policies run sequentially.
+*/
+namespace array_nd
+{
+// min_chunk_bytes chunk size that amortizes dispatch to a thread
+inline constexpr size_t min_chunk_bytes = size_t{1} << 20;
+}
+
+namespace impl
+{
+// for_each_chunk(policy, A, f) calls f(first,last) on flat element ranges
+// of whole outer subarrays of A, as tasks under the execution policy
+template <typename A, typename Policy, typename F>
+void for_each_chunk(Policy&& policy, F f)
+{
+    constexpr size_t rows = std::extent_v<A>;
+    constexpr size_t row_size = strides<A>[0];
+    constexpr size_t chunks = std::clamp(sizeof(A) / array_nd::min_chunk_bytes,
+                                         size_t{1}, rows);
+    if constexpr (chunks == 1)
+        f(size_t{0}, array_size<A>);
+    else
+    {
+        std::vector<size_t> ix(chunks);
+        std::iota(ix.begin(), ix.end(), size_t{0});
+        std::for_each(std::forward<Policy>(policy), ix.begin(), ix.end(),
+            [&f](size_t c) {
+                f(c * rows / chunks * row_size,
+                  (c + 1) * rows / chunks * row_size);
+            });
+    }
+}
+
+template <typename P>
+concept bool execution_policy
+            = std::is_execution_policy_v<std::remove_cvref_t<P>>;
+}
+
+namespace array_nd
+{
+template <typename Policy, typename A>
+requires impl::execution_policy<Policy>
+void fill(Policy&& policy, array_nd_ref<A> a,
+          typename array_nd_ref<A>::value_type const& v)
+{
+    using T = typename array_nd_ref<A>::value_type;
+    auto p = impl::flat(a.a);
+    unsigned char byte{};
+    bool bytes = false;
+    if constexpr (std::is_trivially_copyable_v<T>)
+        bytes = impl::fill_bytes(v, byte);
+    impl::for_each_chunk<A>(std::forward<Policy>(policy),
+        [=,&v](size_t b, size_t e) {
+            if constexpr (std::is_trivially_copyable_v<T>)
+                if (bytes)
+                    return (void)std::memset(p + b, byte, (e - b)*sizeof(T));
+            std::fill(p + b, p + e, v);
+        });
+}
+
+template <typename Policy, typename A, typename Ac>
+requires impl::execution_policy<Policy>
+      && std::is_same_v<std::remove_const_t<A>, std::remove_const_t<Ac>>
+void copy(Policy&& policy, array_nd_ref<Ac> src, array_nd_ref<A> dst)
+{
+    using T = typename array_nd_ref<A>::value_type;
+    auto s = impl::flat(src.a);
+    auto d = impl::flat(dst.a);
+    impl::for_each_chunk<A>(std::forward<Policy>(policy),
+        [=](size_t b, size_t e) {
+            if constexpr (std::is_trivially_copyable_v<T>)
+                std::memmove(d + b, s + b, (e - b) * sizeof(T));
+            else
+                std::copy(s + b, s + e, d + b);
+        });
+}
+
+template <typename Policy, typename A>
+requires impl::execution_policy<Policy>
+void copy(Policy&& policy, A const& src, array_nd_ref<A> dst)
+{
+    copy(std::forward<Policy>(policy), array_nd_ref<A const>{src}, dst);
+}
+
+template <typename Policy, typename A>
+requires impl::execution_policy<Policy>
+      && std::is_swappable_v<std::remove_all_extents_t<A>>
+void swap(Policy&& policy, array_nd_ref<A> x, A& y)
+{
+    auto a = impl::flat(x.a);
+    auto b = impl::flat(y);
+    impl::for_each_chunk<A>(std::forward<Policy>(policy),
+        [=](size_t first, size_t last) {
+            std::swap_ranges(a + first, a + last, b + first);
+        });
+}
+
+template <typename Policy, typename A, typename Ac>
+requires impl::execution_policy<Policy>
+      && std::is_same_v<std::remove_const_t<A>, std::remove_const_t<Ac>>
+bool equal(Policy&& policy, array_nd_ref<A> x, array_nd_ref<Ac> y)
+{
+    auto a = impl::flat(x.a);
+    auto b = impl::flat(y.a);
+    std::atomic<bool> ne{false};
+    impl::for_each_chunk<A>(std::forward<Policy>(policy),
+        [=,&ne](size_t first, size_t last) {
+            if (!ne.load(std::memory_order_relaxed)
+             && !impl::flat_equal(a + first, b + first, last - first))
+                ne.store(true, std::memory_order_relaxed);
+        });
+    return !ne;
+}
+
+template <typename Policy, typename A>
+requires impl::execution_policy<Policy>
+bool equal(Policy&& policy, array_nd_ref<A> x, A const& y)
+{
+    return equal(std::forward<Policy>(policy), x, array_nd_ref<A const>{y});
+}
+}
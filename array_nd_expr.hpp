@@ -0,0 +1,415 @@
+//    Copyright (c) 2018 Will Wray https://keybase.io/willwray
+//
+//   Distributed under the Boost Software License, Version 1.0.
+//          (http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <array>
+#include <functional>
+#include <type_traits>
+
+#include "array_nd_ref.hpp"
+
+/*
+   "array_nd_expr.hpp"
+    ^^^^^^^^^^^^^^^^^
+    Lazy element-wise arithmetic on array_nd_ref, via expression templates.
+
+  Usage:
+      float a[64][64], b[64][64], c[64][64], bias[64];
+      array_nd_ref{c} = array_nd_ref{a} + array_nd_ref{b} * 2.f; // one loop
+      array_nd_ref{c} = array_nd_ref{a} + bias;          // bias per row
+
+  Operators + - * / (and unary -) on array_nd_ref operands build lazy
+  expression nodes; no element is evaluated until the expression is
+  deep-assigned to an array_nd_ref, then all of it is evaluated in one
+  pass over the destination, with no temporary arrays.
+
+  Operands:
+    array_nd_ref<A>  leaf, refers to the viewed array
+    C-array A        leaf, when the other operand is a ref or expression
+    arithmetic T     scalar, applies to every element
+    expression       nested node
+
+  Shapes:
+    Operand shapes broadcast as in NumPy, checked at compile time:
+    extents are aligned on the right and a missing or unit extent
+    stretches to match the other operand, e.g.
+      float[M][N] + float[N]      row vector added to every row
+      float[M][N] * float[M][1]   column vector scales every column
+      float[M][1] - float[N]      outer difference, float[M][N]
+    The expression then broadcasts to the destination shape likewise.
+    The element type of a node is that of its operation on the operand
+    elements, e.g. int[N] * 0.5 is a double[N] expression; it is
+    converted on assignment.
+
+  Evaluation:
+    Expressions whose array operands all have the destination shape are
+    evaluated flat, in one loop. Otherwise evaluation is row by row, the
+    innermost dimension being the row; a broadcast operand is read at
+    stride 0 along a row so its value is held in a register, not reloaded
+    or materialized.
+
+  Aliasing:
+    The destination may be one of the operands, as in x = x + y; each
+    element is read before it is written. Operands that partially overlap
+    the destination, e.g. offset windows of the same array, are not
+    supported, as the fused loop is vectorized assuming no such overlap.
+*/
+namespace impl
+{
+// with_element_t<A,T> array type with the extents of A, element type T
+template <typename A, typename T>
+struct with_element { using type = T; };
+template <typename A, size_t N, typename T>
+struct with_element<A[N],T> { using type = typename with_element<A,T>::type[N]; };
+template <typename A, typename T>
+using with_element_t = typename with_element<A,T>::type;
+
+// broadcast_extents(x,y) NumPy broadcast of extents x and y: aligned
+// on the right, a missing or unit extent stretches to the other one;
+// a 0 extent in the result marks a mismatch (no array has extent 0)
+template <size_t M, size_t N>
+constexpr auto broadcast_extents(std::array<size_t,M> const& x,
+                                 std::array<size_t,N> const& y)
+{
+    constexpr size_t R = M > N ? M : N;
+    std::array<size_t,R> r{};
+    for (size_t d = 0; d != R; ++d)
+    {
+        size_t const a = d < R-M ? 1 : x[d-(R-M)];
+        size_t const b = d < R-N ? 1 : y[d-(R-N)];
+        r[d] = a == 1 ? b : b == 1 || b == a ? a : 0;
+    }
+    return r;
+}
+
+template <size_t N>
+constexpr bool all_nonzero(std::array<size_t,N> const& x)
+{
+    for (size_t e : x)
+        if (e == 0)
+            return false;
+    return true;
+}
+
+// array_from_t<T,X> array type of element type T, extents X
+template <typename T, auto X, size_t D = 0>
+constexpr auto array_from()
+{
+    if constexpr (D == X.size())
+        return std::type_identity<T>{};
+    else
+        return std::type_identity<
+                 typename decltype(array_from<T,X,D+1>())::type[X[D]]>{};
+}
+template <typename T, auto X>
+using array_from_t = typename decltype(array_from<T,X>())::type;
+
+// Expression nodes
+//   array_type   shape of the node, as an array of its value_type
+//   dense        the node and all its operands have the same shape,
+//                or are scalar, so may be evaluated flat
+//   [i]          element at flat index i, if dense
+//   row<RX>(k)   row k of the node broadcast to extents RX, a row being
+//                all of the innermost dimension; an element accessor
+//                [j] for j in [0, RX.back())
+// Leaves broadcast in the innermost dimension load their one element
+// per row, as a scalar, so it is loop invariant along the row.
+
+// expr_scalar<T> scalar operand, rank 0
+template <typename T>
+struct expr_scalar
+{
+    using array_type = T;
+    using value_type = T;
+    static constexpr bool dense = true;
+
+    T v;
+
+    constexpr value_type operator[](size_t) const { return v; }
+
+    template <auto RX>
+    constexpr expr_scalar row(size_t) const { return *this; }
+};
+
+// expr_leaf<A> array operand; A may be const
+template <typename A>
+struct expr_leaf
+{
+    using array_type = std::remove_cv_t<A>;
+    using value_type = std::remove_all_extents_t<array_type>;
+    static constexpr bool dense = true;
+
+    std::remove_extent_t<A>* a;
+
+    constexpr value_type operator[](size_t i) const { return element(a,i); }
+
+    struct row_type
+    {
+        std::remove_extent_t<A>* a;
+        size_t f;
+        constexpr value_type operator[](size_t j) const {
+            return element(a, f + j);
+        }
+    };
+
+    // row<RX>(k) unravels outer index k of RX to the flat offset
+    // of the row's first element, unit extents contributing 0;
+    // broadcast along the row, the row is its one element, a scalar
+    template <auto RX>
+    constexpr auto row(size_t k) const
+    {
+        constexpr size_t r = RX.size(), s = std::rank_v<A>;
+        constexpr auto& ext = extents<array_type>;
+        constexpr auto& str = strides<array_type>;
+        size_t f = 0;
+        for (size_t d = r-1; d-- != 0; )
+        {
+            size_t const i = k % RX[d];
+            k /= RX[d];
+            if (d >= r - s && ext[d-(r-s)] != 1)
+                f += i * str[d-(r-s)];
+        }
+        if constexpr (ext[s-1] != 1)
+            return row_type{a, f};
+        else
+            return expr_scalar<value_type>{element(a, f)};
+    }
+};
+
+// expr_shape_t<L,R,T> broadcast shape of operands L and R, element T
+template <typename L, typename R, typename T>
+constexpr auto expr_shape()
+{
+    constexpr auto x = broadcast_extents(extents<typename L::array_type>,
+                                         extents<typename R::array_type>);
+    static_assert(all_nonzero(x),
+                  "array_nd expression operand shapes do not broadcast");
+    return std::type_identity<array_from_t<T,x>>{};
+}
+template <typename L, typename R, typename T>
+using expr_shape_t = typename decltype(expr_shape<L,R,T>())::type;
+
+// dense_in<X,A> operand X is scalar or of shape A, and dense
+template <typename X, typename A>
+inline constexpr bool dense_in = X::dense
+                    && (std::rank_v<typename X::array_type> == 0
+                     || same_extents<typename X::array_type, A>());
+
+// expr_binary<Op,L,R> node op(l,r) element-wise
+template <typename Op, typename L, typename R>
+struct expr_binary
+{
+    using value_type = std::remove_cvref_t<std::invoke_result_t<Op,
+                        typename L::value_type, typename R::value_type>>;
+    using array_type = expr_shape_t<L,R,value_type>;
+    static constexpr bool dense = dense_in<L,array_type>
+                               && dense_in<R,array_type>;
+
+    L l;
+    R r;
+
+    constexpr value_type operator[](size_t i) const {
+        return Op{}(l[i], r[i]);
+    }
+
+    template <typename LR, typename RR>
+    struct row_type
+    {
+        LR l;
+        RR r;
+        constexpr value_type operator[](size_t j) const {
+            return Op{}(l[j], r[j]);
+        }
+    };
+    template <auto RX>
+    constexpr auto row(size_t k) const
+    {
+        using LR = decltype(l.template row<RX>(k));
+        using RR = decltype(r.template row<RX>(k));
+        return row_type<LR,RR>{l.template row<RX>(k), r.template row<RX>(k)};
+    }
+};
+
+// expr_unary<Op,E> node op(e) element-wise
+template <typename Op, typename E>
+struct expr_unary
+{
+    using value_type = std::remove_cvref_t<std::invoke_result_t<Op,
+                        typename E::value_type>>;
+    using array_type = with_element_t<typename E::array_type, value_type>;
+    static constexpr bool dense = E::dense;
+
+    E e;
+
+    constexpr value_type operator[](size_t i) const { return Op{}(e[i]); }
+
+    template <typename ER>
+    struct row_type
+    {
+        ER e;
+        constexpr value_type operator[](size_t j) const { return Op{}(e[j]); }
+    };
+    template <auto RX>
+    constexpr auto row(size_t k) const
+    {
+        using ER = decltype(e.template row<RX>(k));
+        return row_type<ER>{e.template row<RX>(k)};
+    }
+};
+}
+
+namespace array_nd
+{
+template <typename Op, typename L, typename R>
+inline constexpr bool is_expr_v<impl::expr_binary<Op,L,R>> = true;
+
+template <typename Op, typename E>
+inline constexpr bool is_expr_v<impl::expr_unary<Op,E>> = true;
+}
+
+namespace impl
+{
+template <typename X>
+concept bool expr_operand = array_nd::is_expr_v<X> || is_array_nd_ref_v<X>
+                         || std::is_array_v<X> || std::is_arithmetic_v<X>;
+
+// expr_operands<X,Y> operands of a binary expression; one operand must
+// be a class, a ref or expression, for the operator to be found
+template <typename X, typename Y>
+concept bool expr_operands = expr_operand<X> && expr_operand<Y>
+                          && (array_nd::is_expr_v<X> || is_array_nd_ref_v<X>
+                           || array_nd::is_expr_v<Y> || is_array_nd_ref_v<Y>);
+
+// expr_node(x) the expression node for operand x
+template <typename X>
+constexpr auto expr_node(X const& x)
+{
+    if constexpr (array_nd::is_expr_v<X>)
+        return x;
+    else if constexpr (is_array_nd_ref_v<X>)
+        return expr_leaf<typename X::cv_array_type>{x.a};
+    else if constexpr (std::is_array_v<X>)
+        return expr_leaf<X const>{x};
+    else
+        return expr_scalar<X>{x};
+}
+
+template <typename Op, typename X, typename Y>
+constexpr auto make_expr(X const& x, Y const& y)
+{
+    using L = decltype(expr_node(x));
+    using R = decltype(expr_node(y));
+    return expr_binary<Op,L,R>{expr_node(x), expr_node(y)};
+}
+
+// broadcasts_to<E,D> expression shape E broadcasts to the shape D
+template <typename E, typename D>
+constexpr bool broadcasts_to()
+{
+    if constexpr (std::rank_v<E> > std::rank_v<D>)
+        return false;
+    else
+        return broadcast_extents(extents<E>, extents<D>) == extents<D>;
+}
+
+// expr_assign(x,e) evaluates expression e into the array x refers to;
+// called by array_nd_ref deep operator=. Dense expressions of the same
+// shape evaluate in one flat loop, others row by row.
+template <typename A, typename E>
+constexpr void expr_assign(array_nd_ref<A> x, E const& e)
+{
+    using D = std::remove_cv_t<A>;
+    using EA = typename E::array_type;
+    static_assert(broadcasts_to<EA,D>(),
+                  "array_nd expression shape does not broadcast to the "
+                  "destination shape");
+    constexpr size_t n = array_size<D>;
+    if constexpr (E::dense && same_extents<EA,D>())
+    {
+        if (std::is_constant_evaluated())
+        {
+            for (size_t i = 0; i != n; ++i)
+                element(x.a, i) = e[i];
+            return;
+        }
+        auto* p = flat(x.a);
+#pragma GCC ivdep
+        for (size_t i = 0; i != n; ++i)
+            p[i] = e[i];
+    }
+    else
+    {
+        constexpr auto RX = extents<D>;
+        constexpr size_t N = RX[RX.size()-1];
+        if (std::is_constant_evaluated())
+        {
+            for (size_t k = 0; k != n/N; ++k)
+            {
+                auto const row = e.template row<RX>(k);
+                for (size_t j = 0; j != N; ++j)
+                    element(x.a, k*N + j) = row[j];
+            }
+            return;
+        }
+        auto* p = flat(x.a);
+        for (size_t k = 0; k != n/N; ++k)
+        {
+            auto const row = e.template row<RX>(k);
+            auto* q = p + k*N;
+#pragma GCC ivdep
+            for (size_t j = 0; j != N; ++j)
+                q[j] = row[j];
+        }
+    }
+}
+}
+
+// The operators live with the node types, in namespace impl, for ADL to
+// find them on node operands from any namespace; the using-declarations
+// below make them visible for array_nd_ref operands, of the global one.
+namespace impl
+{
+template <typename X, typename Y>
+requires expr_operands<X,Y>
+constexpr auto operator+(X const& x, Y const& y)
+{
+    return make_expr<std::plus<>>(x, y);
+}
+
+template <typename X, typename Y>
+requires expr_operands<X,Y>
+constexpr auto operator-(X const& x, Y const& y)
+{
+    return make_expr<std::minus<>>(x, y);
+}
+
+template <typename X, typename Y>
+requires expr_operands<X,Y>
+constexpr auto operator*(X const& x, Y const& y)
+{
+    return make_expr<std::multiplies<>>(x, y);
+}
+
+template <typename X, typename Y>
+requires expr_operands<X,Y>
+constexpr auto operator/(X const& x, Y const& y)
+{
+    return make_expr<std::divides<>>(x, y);
+}
+
+template <typename X>
+requires array_nd::is_expr_v<X> || is_array_nd_ref_v<X>
+constexpr auto operator-(X const& x)
+{
+    using E = decltype(expr_node(x));
+    return expr_unary<std::negate<>,E>{expr_node(x)};
+}
+}
+
+using impl::operator+;
+using impl::operator-;
+using impl::operator*;
+using impl::operator/;
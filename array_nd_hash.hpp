@@ -0,0 +1,363 @@
+//    Copyright (c) 2018 Will Wray https://keybase.io/willwray
+//
+//   Distributed under the Boost Software License, Version 1.0.
+//          (http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#include "array_nd_execution.hpp"
+#include "array_nd_reduce.hpp"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define ARRAY_ND_CRC_X86 1
+#endif
+
+/*
+   "array_nd_hash.hpp"
+    ^^^^^^^^^^^^^^^^^
+    Checksums of the byte image of a C-array or array_nd_ref:
+    CRC-32C (Castagnoli) and XXH64.
+
+  Usage:
+      static float snap[256][1024][1024];               // 1 GiB
+      uint32_t c = array_nd::crc32c(std::execution::par, snap);
+      uint64_t h = array_nd::xxhash64(array_nd_ref{snap});
+
+      // or as a snapshot streams to disk, see "array_nd_io.hpp"
+      uint32_t crc = 0;
+      array_nd::write_to(fd, snap, {}, [&](auto bytes, size_t) {
+          crc = array_nd::crc32c(bytes, crc);
+      });
+
+  Functions, in namespace array_nd:
+    crc32c(x, crc = 0)          CRC-32C of the bytes of x, continuing crc,
+                                the CRC of the bytes before; as iSCSI,
+                                ext4, SSE4.2 crc32
+    crc32c(policy, x, crc = 0)  the same, chunks computed as tasks under
+                                the execution policy, then combined
+    crc32c(bytes, crc = 0)      of a span of bytes
+    crc32c_combine(crc1, crc2, n2)
+                                CRC of the concatenation of bytes of CRC
+                                crc1 and n2 bytes of CRC crc2
+    xxhash64(x, seed = 0)       XXH64 of the bytes of x, as xxHash
+    xxhash64(bytes, seed = 0)   of a span of bytes
+
+  x is hashed as its sizeof bytes in memory, in element order; the
+  element type must be trivially copyable. Element padding bytes are
+  hashed, as is, and multibyte elements in native byte order.
+
+  Implementation:
+    CRC-32C, chosen at runtime by __builtin_cpu_supports:
+      SSE4.2 + PCLMUL  three interleaved crc32 instruction streams over
+                       8 KiB blocks, combined by carry-less multiply
+      portable         slicing-by-8 tables
+    A CRC is linear, so the CRC of a concatenation is found from the
+    CRCs of its parts by multiplying by x^(8n) modulo the polynomial,
+    for n bytes following; the parallel overload splits x into chunks
+    of whole outer subarrays, as "array_nd_execution.hpp", and combines
+    the chunk CRCs so.
+    XXH64 is four 64-bit multiply-rotate lanes over 32-byte stripes;
+    its stripes chain serially, so it has no parallel overload.
+    Both are constexpr; constant evaluation hashes a std::bit_cast image.
+*/
+namespace impl
+{
+// load_le<U>(p) the unsigned U stored at p little-endian
+template <typename U>
+constexpr U load_le(unsigned char const* p) noexcept
+{
+    U u = 0;
+    if (std::is_constant_evaluated()
+     || std::endian::native != std::endian::little)
+        for (size_t i = 0; i != sizeof(U); ++i)
+            u |= U(p[i]) << 8*i;
+    else
+        std::memcpy(&u, p, sizeof u);
+    return u;
+}
+
+// crc32c_poly Castagnoli polynomial, bit-reflected: the coefficient
+// of x^k is bit 31 - k, as in the CRC register
+inline constexpr uint32_t crc32c_poly = 0x82f63b78;
+
+// crc32c_table slicing-by-8 tables, [k][b] the CRC register update for
+// byte b followed by k zero bytes
+inline constexpr auto crc32c_table = [] {
+    std::array<std::array<uint32_t,256>,8> t{};
+    for (uint32_t b = 0; b != 256; ++b)
+    {
+        uint32_t c = b;
+        for (int k = 0; k != 8; ++k)
+            c = c >> 1 ^ (c & 1 ? crc32c_poly : 0);
+        t[0][b] = c;
+    }
+    for (size_t k = 1; k != 8; ++k)
+        for (size_t b = 0; b != 256; ++b)
+            t[k][b] = t[k-1][b] >> 8 ^ t[0][t[k-1][b] & 0xff];
+    return t;
+}();
+
+// crc32c_portable(c,p,n) CRC register c updated with n bytes at p
+constexpr uint32_t crc32c_portable(uint32_t c, unsigned char const* p,
+                                   size_t n) noexcept
+{
+    auto const& t = crc32c_table;
+    for (; n >= 8; p += 8, n -= 8)
+    {
+        uint64_t const w = load_le<uint64_t>(p) ^ c;
+        c = t[7][w & 0xff] ^ t[6][w >> 8 & 0xff]
+          ^ t[5][w >> 16 & 0xff] ^ t[4][w >> 24 & 0xff]
+          ^ t[3][w >> 32 & 0xff] ^ t[2][w >> 40 & 0xff]
+          ^ t[1][w >> 48 & 0xff] ^ t[0][w >> 56];
+    }
+    for (; n != 0; --n)
+        c = c >> 8 ^ t[0][(c ^ *p++) & 0xff];
+    return c;
+}
+
+// crc32c_multiply(a,b) a(x) b(x) modulo the polynomial
+constexpr uint32_t crc32c_multiply(uint32_t a, uint32_t b) noexcept
+{
+    uint32_t p = 0;
+    for (uint32_t m = uint32_t{1} << 31; m != 0; m >>= 1)
+    {
+        if (a & m)
+            p ^= b;
+        b = b >> 1 ^ (b & 1 ? crc32c_poly : 0);
+    }
+    return p;
+}
+
+// crc32c_xpow(k) x^k modulo the polynomial, by squares x^(2^j)
+constexpr uint32_t crc32c_xpow(uint64_t k) noexcept
+{
+    uint32_t p = uint32_t{1} << 31, x2j = uint32_t{1} << 30;
+    for (; k != 0; k >>= 1, x2j = crc32c_multiply(x2j, x2j))
+        if (k & 1)
+            p = crc32c_multiply(x2j, p);
+    return p;
+}
+
+// crc32c_shift(c,n) CRC c advanced past n zero bytes, c x^(8n)
+constexpr uint32_t crc32c_shift(uint32_t c, uint64_t n) noexcept
+{
+    return crc32c_multiply(crc32c_xpow(8*n), c);
+}
+
+#if defined(ARRAY_ND_CRC_X86)
+// crc32c_block bytes of each of the three interleaved streams
+inline constexpr size_t crc32c_block = 8192;
+
+// crc32c_x86_multiply(c,k) c k x^33 modulo the polynomial, by carry-less
+// multiply: pclmul of reflected c, k is c k x in 64 bits, which crc32
+// reduces times x^32
+__attribute__((target("sse4.2,pclmul")))
+inline uint64_t crc32c_x86_multiply(uint64_t c, uint32_t k) noexcept
+{
+    __m128i const m = _mm_clmulepi64_si128(_mm_cvtsi32_si128(int(c)),
+                                           _mm_cvtsi32_si128(int(k)), 0);
+    return _mm_crc32_u64(0, uint64_t(_mm_cvtsi128_si64(m)));
+}
+
+// crc32c_x86(c,p,n) as crc32c_portable; the crc32 instruction has a
+// latency of 3 and a throughput of 1, so three streams keep it busy.
+// Streams 1 and 2 start from 0 and are shifted onto stream 0 by
+// k = x^(8B - 33) for each B bytes that follow
+__attribute__((target("sse4.2,pclmul")))
+inline uint32_t crc32c_x86(uint32_t c, unsigned char const* p,
+                           size_t n) noexcept
+{
+    constexpr size_t B = crc32c_block;
+    constexpr uint32_t k1 = crc32c_xpow(8*B - 33);
+    constexpr uint32_t k2 = crc32c_xpow(16*B - 33);
+    uint64_t c0 = c;
+    for (; n >= 3*B; p += 3*B, n -= 3*B)
+    {
+        uint64_t c1 = 0, c2 = 0;
+        for (size_t i = 0; i != B; i += 8)
+        {
+            c0 = _mm_crc32_u64(c0, load_le<uint64_t>(p + i));
+            c1 = _mm_crc32_u64(c1, load_le<uint64_t>(p + B + i));
+            c2 = _mm_crc32_u64(c2, load_le<uint64_t>(p + 2*B + i));
+        }
+        c0 = crc32c_x86_multiply(c0, k2) ^ crc32c_x86_multiply(c1, k1) ^ c2;
+    }
+    for (; n >= 8; p += 8, n -= 8)
+        c0 = _mm_crc32_u64(c0, load_le<uint64_t>(p));
+    for (; n != 0; --n)
+        c0 = _mm_crc32_u8(uint32_t(c0), *p++);
+    return uint32_t(c0);
+}
+
+inline bool has_crc32c_x86() noexcept
+{
+    static bool const yes = __builtin_cpu_supports("sse4.2")
+                         && __builtin_cpu_supports("pclmul");
+    return yes;
+}
+#endif
+
+// crc32c_bytes(crc,p,n) the CRC-32C of n bytes at p, continuing crc
+inline uint32_t crc32c_bytes(uint32_t crc, void const* p, size_t n) noexcept
+{
+    auto const b = static_cast<unsigned char const*>(p);
+#if defined(ARRAY_ND_CRC_X86)
+    if (has_crc32c_x86())
+        return ~crc32c_x86(~crc, b, n);
+#endif
+    return ~crc32c_portable(~crc, b, n);
+}
+
+// byte_image(x) the bytes of C-array or array_nd_ref x, for constant
+// evaluation, by element; out of line, off the runtime stack frame
+template <typename X>
+constexpr auto byte_image(X const& x) noexcept
+{
+    using A = ref_array_t<X>;
+    using T = std::remove_all_extents_t<A>;
+    std::array<unsigned char, sizeof(A)> b{};
+    size_t i = 0;
+    for (T const& v : as_ref(x).elements())
+        for (unsigned char c : std::bit_cast<std::array<unsigned char,
+                                                        sizeof(T)>>(v))
+            b[i++] = c;
+    return b;
+}
+template <typename X>
+constexpr uint32_t crc32c_image(X const& x, uint32_t crc) noexcept
+{
+    auto const b = byte_image(x);
+    return ~crc32c_portable(~crc, b.data(), b.size());
+}
+
+inline constexpr uint64_t xxh64_p1 = 0x9e3779b185ebca87;
+inline constexpr uint64_t xxh64_p2 = 0xc2b2ae3d27d4eb4f;
+inline constexpr uint64_t xxh64_p3 = 0x165667b19e3779f9;
+inline constexpr uint64_t xxh64_p4 = 0x85ebca77c2b2ae63;
+inline constexpr uint64_t xxh64_p5 = 0x27d4eb2f165667c5;
+
+constexpr uint64_t xxh64_round(uint64_t acc, uint64_t in) noexcept
+{
+    return std::rotl(acc + in * xxh64_p2, 31) * xxh64_p1;
+}
+
+// xxh64(p,n,seed) XXH64 of n bytes at p
+constexpr uint64_t xxh64(unsigned char const* p, size_t n,
+                         uint64_t seed) noexcept
+{
+    unsigned char const* const end = p + n;
+    uint64_t h;
+    if (n >= 32)
+    {
+        uint64_t v[4] {seed + xxh64_p1 + xxh64_p2, seed + xxh64_p2,
+                       seed, seed - xxh64_p1};
+        for (; end - p >= 32; p += 32)
+#pragma GCC unroll 4
+            for (size_t l = 0; l != 4; ++l)
+                v[l] = xxh64_round(v[l], load_le<uint64_t>(p + 8*l));
+        h = std::rotl(v[0], 1) + std::rotl(v[1], 7)
+          + std::rotl(v[2], 12) + std::rotl(v[3], 18);
+        for (uint64_t const vl : v)
+            h = (h ^ xxh64_round(0, vl)) * xxh64_p1 + xxh64_p4;
+    }
+    else
+        h = seed + xxh64_p5;
+    h += n;
+    for (; end - p >= 8; p += 8)
+        h = std::rotl(h ^ xxh64_round(0, load_le<uint64_t>(p)), 27)
+          * xxh64_p1 + xxh64_p4;
+    if (end - p >= 4)
+    {
+        h = std::rotl(h ^ load_le<uint32_t>(p) * xxh64_p1, 23)
+          * xxh64_p2 + xxh64_p3;
+        p += 4;
+    }
+    for (; p != end; ++p)
+        h = std::rotl(h ^ *p * xxh64_p5, 11) * xxh64_p1;
+    h = (h ^ h >> 33) * xxh64_p2;
+    h = (h ^ h >> 29) * xxh64_p3;
+    return h ^ h >> 32;
+}
+
+template <typename X>
+constexpr uint64_t xxh64_image(X const& x, uint64_t seed) noexcept
+{
+    auto const b = byte_image(x);
+    return xxh64(b.data(), b.size(), seed);
+}
+
+template <typename X>
+concept bool hashable = array_or_ref<X>
+                     && std::is_trivially_copyable_v<remove_all_extents_t<X>>;
+}
+
+namespace array_nd
+{
+constexpr uint32_t crc32c_combine(uint32_t crc1, uint32_t crc2,
+                                  size_t n2) noexcept
+{
+    return impl::crc32c_shift(crc1, n2) ^ crc2;
+}
+
+inline uint32_t crc32c(std::span<std::byte const> bytes,
+                       uint32_t crc = 0) noexcept
+{
+    return impl::crc32c_bytes(crc, bytes.data(), bytes.size());
+}
+
+template <typename X>
+requires impl::hashable<X>
+constexpr uint32_t crc32c(X const& x, uint32_t crc = 0) noexcept
+{
+    if (std::is_constant_evaluated())
+        return impl::crc32c_image(x, crc);
+    using A = impl::ref_array_t<X>;
+    return impl::crc32c_bytes(crc, impl::as_ref(x).a, sizeof(A));
+}
+
+template <typename Policy, typename X>
+requires impl::execution_policy<Policy> && impl::hashable<X>
+uint32_t crc32c(Policy&& policy, X const& x, uint32_t crc = 0)
+{
+    using A = impl::ref_array_t<X>;
+    using T = std::remove_all_extents_t<A>;
+    auto const p = impl::flat(impl::as_ref(x).a);
+    // the CRC is the XOR of the chunk CRCs, each shifted past the
+    // bytes that follow it, and of crc shifted past all of x
+    std::atomic<uint32_t> sum{impl::crc32c_shift(crc, sizeof(A))};
+    impl::for_each_chunk<A>(std::forward<Policy>(policy),
+        [p,&sum](size_t first, size_t last) {
+            uint32_t const c = impl::crc32c_bytes(0, p + first,
+                                                  (last - first)*sizeof(T));
+            sum.fetch_xor(impl::crc32c_shift(c, sizeof(A) - last*sizeof(T)),
+                          std::memory_order_relaxed);
+        });
+    return sum;
+}
+
+inline uint64_t xxhash64(std::span<std::byte const> bytes,
+                         uint64_t seed = 0) noexcept
+{
+    return impl::xxh64(reinterpret_cast<unsigned char const*>(bytes.data()),
+                       bytes.size(), seed);
+}
+
+template <typename X>
+requires impl::hashable<X>
+constexpr uint64_t xxhash64(X const& x, uint64_t seed = 0) noexcept
+{
+    if (std::is_constant_evaluated())
+        return impl::xxh64_image(x, seed);
+    using A = impl::ref_array_t<X>;
+    return impl::xxh64(reinterpret_cast<unsigned char const*>(
+                           impl::flat(impl::as_ref(x).a)), sizeof(A), seed);
+}
+}
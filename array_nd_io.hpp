@@ -0,0 +1,261 @@
+//    Copyright (c) 2018 Will Wray https://keybase.io/willwray
+//
+//   Distributed under the Boost Software License, Version 1.0.
+//          (http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "array_nd_posix.hpp"
+#include "array_nd_ref.hpp"
+
+/*
+   "array_nd_io.hpp"
+    ^^^^^^^^^^^^^^^
+    Streaming, chunked, pipelined I/O of array_nd_ref contents
+    to and from a file descriptor (POSIX).
+
+  Usage:
+      static double state[64][1024][1024];          // 512 MiB
+      array_nd::write_to(fd, state);
+      array_nd::read_into(array_nd_ref{state}, fd,
+                          {.order = std::endian::big, .direct = true},
+                          [&](std::span<std::byte const> chunk, size_t at) {
+                              crc = array_nd::crc32c(chunk, crc);
+                          });
+
+  Functions, in namespace array_nd:
+    write_to(fd, x, options = {}, on_chunk = {})
+        writes the bytes of x at the fd's file offset
+    read_into(dst, fd, options = {}, on_chunk = {})
+        reads sizeof dst bytes into dst; end of file first throws
+
+  io_options:
+    chunk_bytes    chunk size target, 8 MiB; chunks are whole outer
+                   subarrays, at least one, or for direct I/O whole
+                   direct_align blocks
+    order          byte order of the file; elements, which must then be
+                   arithmetic, are byte-swapped if it is not native
+    direct         O_DIRECT (Linux) through direct_align aligned staging
+                   buffers, if the fd offset is aligned and the file
+                   system allows, else ignored; an unaligned last chunk
+                   is transferred without O_DIRECT
+
+  Pipelining:
+    Two chunks are in flight: while the read or write syscall of one
+    chunk runs on a second thread, the calling thread byte-swaps or
+    stages the next chunk (writing) or the previous chunk (reading) and
+    calls on_chunk(bytes, offset) for it, with the bytes as in the file.
+    on_chunk may compute a checksum, see "array_nd_hash.hpp", report
+    progress, or sleep to throttle. Reads and writes are issued in
+    order, one at a time, so the fd may be a pipe or socket.
+
+  Errors in system calls throw std::system_error, with the errno;
+  exceptions from on_chunk propagate, after the in-flight syscall ends.
+*/
+namespace array_nd
+{
+struct io_options
+{
+    size_t chunk_bytes = size_t{8} << 20;
+    std::endian order = std::endian::native;
+    bool direct = false;
+};
+
+// direct_align O_DIRECT buffer, offset and length alignment
+inline constexpr size_t direct_align = 4096;
+}
+
+namespace impl
+{
+// no_progress default on_chunk
+struct no_progress
+{
+    void operator()(std::span<std::byte const>, size_t) const noexcept {}
+};
+
+// swap_bytes<E>(d,s,n) copies n bytes of E-byte elements s to d,
+// reversing the bytes of each element; d may be s
+template <size_t E>
+void swap_bytes(std::byte* d, std::byte const* s, size_t n) noexcept
+{
+    for (size_t i = 0; i != n; i += E)
+    {
+        std::byte e[E];
+        std::memcpy(e, s + i, E);
+        std::reverse(e, e + E);
+        std::memcpy(d + i, e, E);
+    }
+}
+
+// write_all(fd,p,n), read_all(fd,p,n) loop over partial transfers
+inline void write_all(int fd, std::byte const* p, size_t n)
+{
+    while (n != 0)
+    {
+        ssize_t const w = ::write(fd, p, n);
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w < 0)
+            throw_errno("array_nd::write_to write");
+        p += w;
+        n -= size_t(w);
+    }
+}
+inline void read_all(int fd, std::byte* p, size_t n)
+{
+    read_fully(fd, p, n, "array_nd::read_into read");
+}
+
+// direct_io(fd,on) sets or clears O_DIRECT on fd, returning success
+inline bool direct_io(int fd, bool on) noexcept
+{
+#ifdef O_DIRECT
+    int const fl = ::fcntl(fd, F_GETFL);
+    return fl >= 0
+        && ::fcntl(fd, F_SETFL, on ? fl | O_DIRECT : fl & ~O_DIRECT) == 0;
+#else
+    return !on;
+#endif
+}
+
+// chunk_io plans the chunks and staging buffers of one transfer
+template <typename A>
+struct chunk_io
+{
+    using T = std::remove_cv_t<std::remove_all_extents_t<A>>;
+
+    int fd;
+    bool swap;
+    bool direct;
+    size_t chunk;
+    std::unique_ptr<std::byte, void(*)(std::byte*)> buf{nullptr, release};
+
+    chunk_io(int f, array_nd::io_options const& o, bool stage_swaps)
+      : fd{f}, swap{o.order != std::endian::native}, direct{o.direct}
+    {
+        if constexpr (!std::is_arithmetic_v<T>)
+            if (swap)
+                throw std::invalid_argument(
+                    "array_nd io: byte order conversion of non-arithmetic");
+        if (direct)
+        {
+            off_t const at = ::lseek(fd, 0, SEEK_CUR);
+            direct = at >= 0 && at % array_nd::direct_align == 0
+                  && direct_io(fd, true);
+        }
+        constexpr size_t row = sizeof(std::remove_extent_t<A>);
+        chunk = direct
+              ? std::max(o.chunk_bytes / array_nd::direct_align, size_t{1})
+                * array_nd::direct_align
+              : std::max(o.chunk_bytes / row, size_t{1}) * row;
+        chunk = std::min(chunk, sizeof(A));
+        if (direct || (swap && stage_swaps))
+            buf.reset(static_cast<std::byte*>(::operator new(2*chunk,
+                             std::align_val_t{array_nd::direct_align})));
+    }
+    ~chunk_io() { if (direct) direct_io(fd, false); }
+
+    static void release(std::byte* p) {
+        ::operator delete(p, std::align_val_t{array_nd::direct_align});
+    }
+
+    size_t chunks() const noexcept { return (sizeof(A) + chunk-1) / chunk; }
+    size_t size(size_t k) const noexcept {
+        return std::min(chunk, sizeof(A) - k*chunk);
+    }
+    std::byte* staging(size_t k) const noexcept {
+        return buf.get() + (k % 2) * chunk;
+    }
+    // unaligned(k) clears O_DIRECT before a chunk k not a whole block
+    void unaligned(size_t k)
+    {
+        if (direct && size(k) % array_nd::direct_align != 0)
+            direct = !direct_io(fd, false);
+    }
+    void convert(std::byte* d, std::byte const* s, size_t n) const noexcept
+    {
+        if (swap)
+            swap_bytes<sizeof(T)>(d, s, n);
+        else if (d != s)
+            std::memcpy(d, s, n);
+    }
+};
+}
+
+namespace array_nd
+{
+template <typename X, typename F = impl::no_progress>
+requires (std::is_array_v<X> || is_array_nd_ref_v<X>)
+      && std::is_trivially_copyable_v<remove_all_extents_t<X>>
+      && std::is_invocable_v<F&, std::span<std::byte const>, size_t>
+void write_to(int fd, X const& x, io_options const& opt = {},
+              F on_chunk = {})
+{
+    using A = typename decltype(array_nd_ref{x})::array_type;
+    auto const src = reinterpret_cast<std::byte const*>(
+                         impl::flat(array_nd_ref{x}.a));
+    impl::chunk_io<A> io{fd, opt, true};
+    std::future<void> pending;
+    for (size_t k = 0; k != io.chunks(); ++k)
+    {
+        size_t const at = k * io.chunk, n = io.size(k);
+        std::byte const* out = src + at;
+        if (io.buf)
+        {
+            io.convert(io.staging(k), out, n);
+            out = io.staging(k);
+        }
+        on_chunk(std::span{out, n}, at);
+        if (pending.valid())
+            pending.get();
+        io.unaligned(k);
+        pending = std::async(std::launch::async,
+                             [fd, out, n] { impl::write_all(fd, out, n); });
+    }
+    if (pending.valid())
+        pending.get();
+}
+
+template <typename A, typename F = impl::no_progress>
+requires (!std::is_const_v<A>)
+      && std::is_trivially_copyable_v<std::remove_all_extents_t<A>>
+      && std::is_invocable_v<F&, std::span<std::byte const>, size_t>
+void read_into(array_nd_ref<A> dst, int fd, io_options const& opt = {},
+               F on_chunk = {})
+{
+    auto const d = reinterpret_cast<std::byte*>(impl::flat(dst.a));
+    impl::chunk_io<A> io{fd, opt, false};
+    auto const target = [&](size_t k) {
+        return io.buf ? io.staging(k) : d + k * io.chunk;
+    };
+    auto const start = [&](size_t k) {
+        io.unaligned(k);
+        return std::async(std::launch::async,
+                          [fd = io.fd, p = target(k), n = io.size(k)] {
+                              impl::read_all(fd, p, n);
+                          });
+    };
+    std::future<void> pending = start(0);
+    for (size_t k = 0; k != io.chunks(); ++k)
+    {
+        pending.get();
+        if (k + 1 != io.chunks())
+            pending = start(k + 1);
+        size_t const at = k * io.chunk, n = io.size(k);
+        on_chunk(std::span<std::byte const>{target(k), n}, at);
+        io.convert(d + at, target(k), n);
+    }
+}
+}
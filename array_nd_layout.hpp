@@ -0,0 +1,357 @@
+//    Copyright (c) 2018 Will Wray https://keybase.io/willwray
+//
+//   Distributed under the Boost Software License, Version 1.0.
+//          (http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <bit>
+#include <cstdint>
+
+#include "array_nd_ref.hpp"
+
+/*
+   "array_nd_layout.hpp"
+    ^^^^^^^^^^^^^^^^^^^
+    This header defines array_nd_layout_ref, a view of logical shape A
+    over elements stored in the order given by a layout policy L.
+
+  Usage:
+      float buf[array_nd_layout_ref<float[256][256], array_nd::morton>
+                ::required_span_size];
+      auto z = array_nd_layout_ref<float[256][256], array_nd::morton>{buf};
+      z.assign(array_nd_ref{image}); // re-layout row-major image
+      z(i,j) += 1;                   // logical indexing
+
+  Layout policies, in namespace array_nd:
+    row_major          C-array order T[L][M][N]; today's array_nd_ref
+    column_major       Fortran order, first index fastest
+    tiled<TR,TC>       rank 2; TR x TC row-major tiles laid out row-major,
+                       extents padded up to whole tiles
+    morton             rank 2, power-of-two extents; Z-order, with the
+                       bits of i and j interleaved (j in the low bit)
+
+  A layout policy L provides mapping<A> with
+    array_type              A
+    required_span_size      elements of storage needed, >= array_size<A>
+    offset(ix)              storage offset of multi-index ix
+    for_each(f)             calls f(offset, ix) for all elements
+                            in storage order, i.e. offset 0,1,2,...
+                            (skipping any padding)
+
+  array_nd_layout_ref<A,L>
+    Holds element_type* to required_span_size elements.
+    operator()(i,j,...) full multi-index element access.
+    for_each(f) visits f(element&, ix) in storage order.
+    fill, assign (deep copy from any layout, or array_nd_ref), ==.
+    Copy between layouts runs in destination storage order, so writes
+    stream; row-major <-> column-major copies go by cache blocks.
+*/
+namespace array_nd
+{
+// index_t<A> multi-index type for array A
+template <typename A>
+using index_t = std::array<size_t, std::rank_v<A>>;
+
+struct row_major
+{
+    template <typename A>
+    struct mapping
+    {
+        using array_type = A;
+        static constexpr size_t required_span_size = array_size<A>;
+
+        static constexpr size_t offset(index_t<A> const& ix) noexcept
+        {
+            size_t off = 0;
+            for (unsigned d = 0; d != ix.size(); ++d)
+                off += ix[d] * impl::strides<A>[d];
+            return off;
+        }
+        template <typename F>
+        static constexpr void for_each(F f)
+        {
+            constexpr auto& ex = impl::extents<A>;
+            index_t<A> ix{};
+            for (size_t off = 0; off != required_span_size; ++off)
+            {
+                f(off, ix);
+                for (unsigned d = ix.size(); d-- != 0 && ++ix[d] == ex[d]; )
+                    ix[d] = 0;
+            }
+        }
+    };
+};
+
+struct column_major
+{
+    template <typename A>
+    struct mapping
+    {
+        using array_type = A;
+        static constexpr size_t required_span_size = array_size<A>;
+        static constexpr unsigned R = std::rank_v<A>;
+
+        static constexpr auto& extents = impl::extents<A>;
+        static constexpr index_t<A> strides = [] {
+            index_t<A> s{};
+            size_t n = 1;
+            for (unsigned d = 0; d != R; n *= extents[d++])
+                s[d] = n;
+            return s;
+        }();
+
+        static constexpr size_t offset(index_t<A> const& ix) noexcept
+        {
+            size_t off = 0;
+            for (unsigned d = 0; d != R; ++d)
+                off += ix[d] * strides[d];
+            return off;
+        }
+        template <typename F>
+        static constexpr void for_each(F f)
+        {
+            index_t<A> ix{};
+            for (size_t off = 0; off != required_span_size; ++off)
+            {
+                f(off, ix);
+                for (unsigned d = 0; d != R && ++ix[d] == extents[d]; ++d)
+                    ix[d] = 0;
+            }
+        }
+    };
+};
+
+template <size_t TR, size_t TC>
+requires TR != 0 && TC != 0
+struct tiled
+{
+    static constexpr size_t tile_rows = TR;
+    static constexpr size_t tile_cols = TC;
+
+    template <typename A>
+    requires (std::rank_v<A> == 2)
+    struct mapping
+    {
+        using array_type = A;
+        static constexpr size_t M = std::extent_v<A,0>;
+        static constexpr size_t N = std::extent_v<A,1>;
+        static constexpr size_t tiles_down = (M + TR-1) / TR;
+        static constexpr size_t tiles_across = (N + TC-1) / TC;
+        static constexpr size_t required_span_size
+                              = tiles_down * tiles_across * TR*TC;
+
+        static constexpr size_t offset(index_t<A> const& ix) noexcept
+        {
+            auto [i,j] = ix;
+            return ((i/TR)*tiles_across + j/TC)*(TR*TC) + (i%TR)*TC + j%TC;
+        }
+        template <typename F>
+        static constexpr void for_each(F f)
+        {
+            for (size_t ti = 0; ti != tiles_down; ++ti)
+            for (size_t tj = 0; tj != tiles_across; ++tj)
+            {
+                size_t off = (ti*tiles_across + tj)*(TR*TC);
+                for (size_t r = 0; r != TR; ++r, off += TC)
+                {
+                    size_t const i = ti*TR + r;
+                    if (i == M)
+                        break;
+                    for (size_t c = 0; c != TC && tj*TC + c != N; ++c)
+                        f(off + c, index_t<A>{i, tj*TC + c});
+                }
+            }
+        }
+    };
+};
+
+struct morton
+{
+    template <typename A>
+    requires (std::rank_v<A> == 2)
+          && std::has_single_bit(std::extent_v<A,0>)
+          && std::has_single_bit(std::extent_v<A,1>)
+    struct mapping
+    {
+        using array_type = A;
+        static constexpr size_t M = std::extent_v<A,0>;
+        static constexpr size_t N = std::extent_v<A,1>;
+        static constexpr size_t required_span_size = M*N;
+        // k low bits of each of i and j are interleaved; the remaining
+        // high bits of the longer dimension go above, in order
+        static constexpr unsigned k = std::countr_zero(std::min(M,N));
+        static constexpr size_t low = (size_t{1} << k) - 1;
+
+        // spread(x) moves bit n of 32-bit x to bit 2n
+        static constexpr uint64_t spread(uint64_t x) noexcept
+        {
+            x = (x | x << 16) & 0x0000FFFF0000FFFF;
+            x = (x | x << 8)  & 0x00FF00FF00FF00FF;
+            x = (x | x << 4)  & 0x0F0F0F0F0F0F0F0F;
+            x = (x | x << 2)  & 0x3333333333333333;
+            x = (x | x << 1)  & 0x5555555555555555;
+            return x;
+        }
+        // compact(x) inverse of spread, bit 2n of x to bit n
+        static constexpr uint64_t compact(uint64_t x) noexcept
+        {
+            x &= 0x5555555555555555;
+            x = (x | x >> 1)  & 0x3333333333333333;
+            x = (x | x >> 2)  & 0x0F0F0F0F0F0F0F0F;
+            x = (x | x >> 4)  & 0x00FF00FF00FF00FF;
+            x = (x | x >> 8)  & 0x0000FFFF0000FFFF;
+            x = (x | x >> 16) & 0x00000000FFFFFFFF;
+            return x;
+        }
+
+        static constexpr size_t offset(index_t<A> const& ix) noexcept
+        {
+            auto [i,j] = ix;
+            return (spread(i & low) << 1 | spread(j & low))
+                 | ((i >> k | j >> k) << 2*k);
+        }
+        template <typename F>
+        static constexpr void for_each(F f)
+        {
+            for (size_t off = 0; off != required_span_size; ++off)
+            {
+                size_t const z = off & ((size_t{1} << 2*k) - 1);
+                size_t const h = off >> 2*k;
+                size_t i = compact(z >> 1), j = compact(z);
+                if constexpr (M > N) i |= h << k; else j |= h << k;
+                f(off, index_t<A>{i, j});
+            }
+        }
+    };
+};
+}
+
+template <typename A, typename L = array_nd::row_major>
+requires std::is_array_v<A> && std::extent_v<A> != 0
+struct array_nd_layout_ref
+{
+    using type            = array_nd_layout_ref;
+    using layout_type     = L;
+    using mapping_type    = typename L::template mapping<std::remove_cv_t<A>>;
+    using cv_array_type   = A;
+    using array_type      = std::remove_cv_t<A>;
+    using element_type    = std::remove_all_extents_t<A>;
+    using value_type      = std::remove_cv_t<element_type>;
+    using index_type      = array_nd::index_t<A>;
+    using pointer         = element_type*;
+    using reference       = element_type&;
+
+    static constexpr unsigned rank = std::rank_v<A>;
+    static constexpr size_t required_span_size
+                          = mapping_type::required_span_size;
+
+    pointer p;
+
+    constexpr array_nd_layout_ref(pointer p) noexcept : p{p} {}
+
+    // A row-major layout ref views array_nd_ref or C-array storage
+    // of the same extents, and of the element type or less cv-qualified
+    template <typename B = A>
+    requires std::is_same_v<L, array_nd::row_major>
+          && (impl::same_extents<std::remove_cv_t<B>, array_type>())
+          && std::is_convertible_v<std::remove_all_extents_t<B>(*)[],
+                                   element_type(*)[]>
+    constexpr array_nd_layout_ref(array_nd_ref<B> r) noexcept
+        : p{impl::flat(r.a)} {}
+
+    static constexpr size_t extent(unsigned d) noexcept {
+        return impl::extents<A>[d];
+    }
+
+    template <typename... I>
+    requires (sizeof...(I) == rank) && (std::is_integral_v<I> && ...)
+    constexpr reference operator()(I... i) const noexcept
+    {
+        return p[mapping_type::offset({static_cast<size_t>(i)...})];
+    }
+    constexpr reference operator[](index_type const& ix) const noexcept
+    {
+        return p[mapping_type::offset(ix)];
+    }
+
+    // for_each(f) calls f(element&, multi-index) in storage order
+    template <typename F>
+    constexpr void for_each(F f) const
+    {
+        mapping_type::for_each([&](size_t off, index_type const& ix) {
+            f(p[off], ix);
+        });
+    }
+
+    constexpr void fill(value_type const& e) const
+    {
+        std::fill_n(p, required_span_size, e);
+    }
+
+    // deep copy from array_nd_layout_ref of any layout, or array_nd_ref
+    template <typename B, typename L2>
+    constexpr void assign(array_nd_layout_ref<B,L2> src) const;
+    template <typename B>
+    constexpr void assign(array_nd_ref<B> src) const
+    {
+        assign(array_nd_layout_ref<B>{src});
+    }
+};
+
+namespace impl
+{
+// is_row_col_transpose<L1,L2,A> true for a rank 2 row <-> column copy
+template <typename L1, typename L2, typename A>
+inline constexpr bool is_row_col_transpose = std::rank_v<A> == 2
+     && ((std::is_same_v<L1, array_nd::row_major>
+       && std::is_same_v<L2, array_nd::column_major>)
+      || (std::is_same_v<L1, array_nd::column_major>
+       && std::is_same_v<L2, array_nd::row_major>));
+}
+
+template <typename A, typename L>
+requires std::is_array_v<A> && std::extent_v<A> != 0
+template <typename B, typename L2>
+constexpr void
+array_nd_layout_ref<A,L>::assign(array_nd_layout_ref<B,L2> src) const
+{
+    static_assert(std::is_same_v<array_type, std::remove_cv_t<B>>,
+                  "array_nd_layout_ref::assign shape mismatch");
+    if constexpr (std::is_same_v<L, L2>)
+        std::copy_n(src.p, required_span_size, p);
+    else if constexpr (impl::is_row_col_transpose<L, L2, array_type>)
+    {
+        // cache-blocked; both sides are row-major in some index order
+        constexpr size_t M = std::extent_v<A,0>, N = std::extent_v<A,1>;
+        constexpr size_t blk = 32;
+        for (size_t i0 = 0; i0 < M; i0 += blk)
+        for (size_t j0 = 0; j0 < N; j0 += blk)
+        for (size_t i = i0; i != std::min(i0+blk, M); ++i)
+        for (size_t j = j0; j != std::min(j0+blk, N); ++j)
+            (*this)(i,j) = src(i,j);
+    }
+    else
+        mapping_type::for_each([&](size_t off, index_type const& ix) {
+            p[off] = src[ix];
+        });
+}
+
+template <typename A, typename L, typename B, typename L2>
+requires std::is_same_v<std::remove_cv_t<A>, std::remove_cv_t<B>>
+constexpr bool
+operator==( array_nd_layout_ref<A,L> x, array_nd_layout_ref<B,L2> y)
+{
+    // flat compare when there's no padding in storage
+    if constexpr (std::is_same_v<L, L2>
+               && array_nd_layout_ref<A,L>::required_span_size == array_size<A>)
+        return impl::flat_equal(x.p, y.p, array_size<A>);
+    else
+    {
+        bool eq = true;
+        x.for_each([&](auto& e, auto const& ix) {
+            eq = eq && e == y[ix];
+        });
+        return eq;
+    }
+}
@@ -0,0 +1,306 @@
+//    Copyright (c) 2018 Will Wray https://keybase.io/willwray
+//
+//   Distributed under the Boost Software License, Version 1.0.
+//          (http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "array_nd_ref.hpp"
+#include "array_nd_small.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ARRAY_ND_GEMM_X86 1
+#endif
+
+/*
+   "array_nd_matmul.hpp"
+    ^^^^^^^^^^^^^^^^^^^
+    Matrix multiply for rank 2 array_nd_ref, C = A B.
+
+  Usage:
+      float a[256][128], b[128][64], c[256][64];
+      array_nd::matmul(array_nd_ref{c}, array_nd_ref{a}, array_nd_ref{b});
+
+  matmul(c, a, b)
+    c: T[M][N], a: T[M][K], b: T[K][N], a and b may be const.
+    Shapes are checked at compile time, by constraint.
+    c is overwritten; it must not overlap a or b.
+
+  Implementation:
+    Small matrices, all extents 2 to 8, use the fully unrolled kernel of
+    "array_nd_small.hpp", at runtime and in constant evaluation.
+    Otherwise constant evaluation uses the triple loop, c[i][j] = sum a[i][k]b[k][j].
+    At runtime, small products, and non-arithmetic element types, run
+    an i-k-j loop that vectorizes along rows of b and c.
+    Larger arithmetic products are blocked as in GotoBLAS / BLIS:
+      a KC x NC block of b is packed into NR-column panels,
+      an MC x KC block of a is packed into MR-row panels,
+      then an MR x NR micro-kernel holds a tile of c in registers
+      as it accumulates rank 1 updates along the packed panels.
+    Panels are zero-padded at the edges, so the micro-kernel only sees
+    whole tiles; edge tiles of c are staged through a local tile.
+    Micro-kernels, chosen at runtime by __builtin_cpu_supports:
+      AVX2 + FMA  6x16 float, 6x8 double   (target attribute, intrinsics)
+      portable    4x8, unrolled loops, vectorized as the build allows
+*/
+namespace impl
+{
+// gemm_small product size M*N*K below which packing does not pay
+inline constexpr size_t gemm_small = 32 * 32 * 32;
+
+// gemm_block<T> cache blocking: KC x NC block of b ~ half of L2..L3,
+// MC x KC block of a ~ L2, micro-panel of b KC x NR ~ L1
+template <typename T>
+struct gemm_block
+{
+    static constexpr size_t KC = 256;
+    static constexpr size_t MC = 72;    // multiple of MR = 4 and 6
+    static constexpr size_t NC = (size_t{2} << 20) / (KC * sizeof(T))
+                               / 16 * 16;
+};
+
+// gemm_loop(M,N,K,a,b,c) row-major i-k-j product, no packing
+template <typename T>
+void gemm_loop(size_t M, size_t N, size_t K,
+               T const* a, T const* b, T* c)
+{
+    for (size_t i = 0; i != M; ++i)
+    {
+        T* ci = c + i*N;
+        std::fill_n(ci, N, T{});
+        for (size_t k = 0; k != K; ++k)
+        {
+            T const aik = a[i*K + k];
+            T const* bk = b + k*N;
+            for (size_t j = 0; j != N; ++j)
+                ci[j] += aik * bk[j];
+        }
+    }
+}
+
+// Micro-kernels: c[MR][NR] (row stride ldc) = or += the product of
+// packed panels a (kc x MR, column-major) and b (kc x NR, row-major)
+
+template <typename T, size_t MR, size_t NR>
+inline void gemm_kernel(size_t kc, T const* a, T const* b,
+                        T* c, size_t ldc, bool add)
+{
+    T acc[MR][NR] {};
+    for (size_t p = 0; p != kc; ++p, a += MR, b += NR)
+#pragma GCC unroll 8
+        for (size_t i = 0; i != MR; ++i)
+#pragma GCC unroll 16
+            for (size_t j = 0; j != NR; ++j)
+                acc[i][j] += a[i] * b[j];
+    for (size_t i = 0; i != MR; ++i)
+        for (size_t j = 0; j != NR; ++j)
+            c[i*ldc + j] = add ? c[i*ldc + j] + acc[i][j] : acc[i][j];
+}
+
+#if defined(ARRAY_ND_GEMM_X86)
+__attribute__((target("avx2,fma")))
+inline void gemm_kernel_avx2(size_t kc, float const* a, float const* b,
+                             float* c, size_t ldc, bool add)
+{
+    __m256 acc[6][2];
+#pragma GCC unroll 6
+    for (auto& r : acc)
+        r[0] = r[1] = _mm256_setzero_ps();
+    for (size_t p = 0; p != kc; ++p, a += 6, b += 16)
+    {
+        __m256 const b0 = _mm256_loadu_ps(b), b1 = _mm256_loadu_ps(b + 8);
+#pragma GCC unroll 6
+        for (size_t i = 0; i != 6; ++i)
+        {
+            __m256 const ai = _mm256_broadcast_ss(a + i);
+            acc[i][0] = _mm256_fmadd_ps(ai, b0, acc[i][0]);
+            acc[i][1] = _mm256_fmadd_ps(ai, b1, acc[i][1]);
+        }
+    }
+#pragma GCC unroll 6
+    for (size_t i = 0; i != 6; ++i, c += ldc)
+        for (size_t h = 0; h != 2; ++h)
+            _mm256_storeu_ps(c + 8*h, add ? _mm256_add_ps(
+                             _mm256_loadu_ps(c + 8*h), acc[i][h]) : acc[i][h]);
+}
+
+__attribute__((target("avx2,fma")))
+inline void gemm_kernel_avx2(size_t kc, double const* a, double const* b,
+                             double* c, size_t ldc, bool add)
+{
+    __m256d acc[6][2];
+#pragma GCC unroll 6
+    for (auto& r : acc)
+        r[0] = r[1] = _mm256_setzero_pd();
+    for (size_t p = 0; p != kc; ++p, a += 6, b += 8)
+    {
+        __m256d const b0 = _mm256_loadu_pd(b), b1 = _mm256_loadu_pd(b + 4);
+#pragma GCC unroll 6
+        for (size_t i = 0; i != 6; ++i)
+        {
+            __m256d const ai = _mm256_broadcast_sd(a + i);
+            acc[i][0] = _mm256_fmadd_pd(ai, b0, acc[i][0]);
+            acc[i][1] = _mm256_fmadd_pd(ai, b1, acc[i][1]);
+        }
+    }
+#pragma GCC unroll 6
+    for (size_t i = 0; i != 6; ++i, c += ldc)
+        for (size_t h = 0; h != 2; ++h)
+            _mm256_storeu_pd(c + 4*h, add ? _mm256_add_pd(
+                             _mm256_loadu_pd(c + 4*h), acc[i][h]) : acc[i][h]);
+}
+
+inline bool has_avx2_fma() noexcept
+{
+    static bool const yes = __builtin_cpu_supports("avx2")
+                         && __builtin_cpu_supports("fma");
+    return yes;
+}
+#endif
+
+// gemm_packed<T,MR,NR>(M,N,K,a,b,c,kernel) blocked, packed product
+template <typename T, size_t MR, size_t NR, typename Kernel>
+void gemm_packed(size_t M, size_t N, size_t K,
+                 T const* a, T const* b, T* c, Kernel kernel)
+{
+    using B = gemm_block<T>;
+    constexpr size_t KC = B::KC, MC = B::MC / MR * MR, NC = B::NC / NR * NR;
+    thread_local std::vector<T> apack, bpack;
+    apack.resize(MC * KC);
+    bpack.resize(KC * NC);
+
+    for (size_t jc = 0; jc < N; jc += NC)
+    {
+        size_t const nc = std::min(NC, N - jc);
+        for (size_t pc = 0; pc < K; pc += KC)
+        {
+            size_t const kc = std::min(KC, K - pc);
+            // pack b[pc:pc+kc][jc:jc+nc] into NR-column panels
+            for (size_t jr = 0; jr < nc; jr += NR)
+            {
+                T* bp = bpack.data() + jr*kc;
+                size_t const nr = std::min(NR, nc - jr);
+                for (size_t p = 0; p != kc; ++p, bp += NR)
+                {
+                    T const* bk = b + (pc + p)*N + jc + jr;
+                    std::copy_n(bk, nr, bp);
+                    std::fill(bp + nr, bp + NR, T{});
+                }
+            }
+            for (size_t ic = 0; ic < M; ic += MC)
+            {
+                size_t const mc = std::min(MC, M - ic);
+                // pack a[ic:ic+mc][pc:pc+kc] into MR-row panels
+                for (size_t ir = 0; ir < mc; ir += MR)
+                {
+                    T* ap = apack.data() + ir*kc;
+                    size_t const mr = std::min(MR, mc - ir);
+                    for (size_t p = 0; p != kc; ++p, ap += MR)
+                    {
+                        for (size_t i = 0; i != mr; ++i)
+                            ap[i] = a[(ic + ir + i)*K + pc + p];
+                        std::fill(ap + mr, ap + MR, T{});
+                    }
+                }
+                for (size_t jr = 0; jr < nc; jr += NR)
+                {
+                    size_t const nr = std::min(NR, nc - jr);
+                    for (size_t ir = 0; ir < mc; ir += MR)
+                    {
+                        size_t const mr = std::min(MR, mc - ir);
+                        T* ct = c + (ic + ir)*N + jc + jr;
+                        T const* ap = apack.data() + ir*kc;
+                        T const* bp = bpack.data() + jr*kc;
+                        if (mr == MR && nr == NR)
+                            kernel(kc, ap, bp, ct, N, pc != 0);
+                        else
+                        {
+                            T tile[MR][NR];
+                            kernel(kc, ap, bp, &tile[0][0], NR, false);
+                            for (size_t i = 0; i != mr; ++i)
+                                for (size_t j = 0; j != nr; ++j)
+                                    ct[i*N + j] = pc != 0
+                                        ? ct[i*N + j] + tile[i][j]
+                                        : tile[i][j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// gemm(M,N,K,a,b,c) runtime product of flat row-major matrices
+template <typename T>
+void gemm(size_t M, size_t N, size_t K, T const* a, T const* b, T* c)
+{
+    if constexpr (std::is_arithmetic_v<T>)
+    {
+        if (M*N*K >= gemm_small)
+        {
+#if defined(ARRAY_ND_GEMM_X86)
+            if constexpr (std::is_same_v<T,float> || std::is_same_v<T,double>)
+            {
+                if (has_avx2_fma())
+                {
+                    constexpr size_t NR = 64 / sizeof(T);
+                    gemm_packed<T,6,NR>(M, N, K, a, b, c,
+                        [](size_t kc, T const* ap, T const* bp,
+                           T* ct, size_t ldc, bool add) {
+                            gemm_kernel_avx2(kc, ap, bp, ct, ldc, add);
+                        });
+                    return;
+                }
+            }
+#endif
+            gemm_packed<T,4,8>(M, N, K, a, b, c, gemm_kernel<T,4,8>);
+            return;
+        }
+    }
+    gemm_loop(M, N, K, a, b, c);
+}
+}
+
+namespace array_nd
+{
+// matmul(c,a,b) matrix product c = a b; c must not overlap a or b
+template <typename C, typename A, typename B>
+requires (std::rank_v<C> == 2) && (std::rank_v<A> == 2)
+      && (std::rank_v<B> == 2)
+      && (std::extent_v<A,1> == std::extent_v<B,0>)
+      && (std::extent_v<C,0> == std::extent_v<A,0>)
+      && (std::extent_v<C,1> == std::extent_v<B,1>)
+      && (!std::is_const_v<C>)
+      && std::is_same_v<std::remove_cv_t<std::remove_all_extents_t<A>>,
+                        std::remove_all_extents_t<C>>
+      && std::is_same_v<std::remove_cv_t<std::remove_all_extents_t<B>>,
+                        std::remove_all_extents_t<C>>
+constexpr array_nd_ref<C> matmul(array_nd_ref<C> c,
+                                 array_nd_ref<A> a, array_nd_ref<B> b)
+{
+    constexpr size_t M = std::extent_v<A,0>, K = std::extent_v<A,1>,
+                     N = std::extent_v<B,1>;
+    using T = std::remove_all_extents_t<C>;
+    if constexpr (impl::small_matrix<A> && impl::small_matrix<B>)
+        impl::small_matmul(c, a, b);
+    else if (std::is_constant_evaluated())
+    {
+        for (size_t i = 0; i != M; ++i)
+            for (size_t j = 0; j != N; ++j)
+            {
+                T s{};
+                for (size_t k = 0; k != K; ++k)
+                    s += a[i][k] * b[k][j];
+                c[i][j] = s;
+            }
+    }
+    else
+        impl::gemm<T>(M, N, K, impl::flat(a.a), impl::flat(b.a),
+                      impl::flat(c.a));
+    return c;
+}
+}
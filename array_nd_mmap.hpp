@@ -0,0 +1,250 @@
+//    Copyright (c) 2018 Will Wray https://keybase.io/willwray
+//
+//   Distributed under the Boost Software License, Version 1.0.
+//          (http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <bit>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "array_nd_npy.hpp"
+#include "array_nd_posix.hpp"
+
+/*
+   "array_nd_mmap.hpp"
+    ^^^^^^^^^^^^^^^^^
+    array_nd::mapped_array, a memory-mapped file viewed as a C-array
+    of fixed shape, with no copy on load (POSIX).
+
+  Usage:
+      using grid = float[4096][4096];
+      auto out = array_nd::mapped_array<grid>::create("grid.bin");
+      out.ref() = ...;                  // write through the mapping
+      out.sync();                       // msync, flush to the file
+
+      auto in = array_nd::mapped_array<grid const>::open("grid.bin");
+      in.advise(MADV_WILLNEED);         // prefetch, a madvise hint
+      array_nd_ref<grid const> g = in;  // pages load on first access
+
+  mapped_array<A>
+    Owns one shared mapping of a file holding an A, and unmaps it on
+    destruction; move-only. The mapping is read-only for const A, which
+    gives array_nd_ref<A const> views, else read-write.
+    The element type must be trivially copyable.
+
+  Functions:
+    open(path, layout)    maps an existing file, throws if its size,
+                          or header, does not match A
+    create(path, layout)  creates or truncates the file to hold A,
+                          zero-filled, and maps it; for non-const A
+    ref(), data()         the array_nd_ref view, the A& array
+    advise(advice)        madvise the mapping, MADV_SEQUENTIAL etc.
+    sync(wait = true)     msync, MS_SYNC or else MS_ASYNC
+
+  File layout:
+    file_layout::raw      the file is exactly the sizeof(A) bytes of A
+    file_layout::header   a 256 byte array_file_header precedes the A;
+                          it records the element type kind, size and
+                          byte order, and the rank and extents, which
+                          open checks against A
+    file_layout::npy      a NumPy .npy file, see "array_nd_npy.hpp";
+                          open checks its dtype and shape against A,
+                          and that its payload is aligned for the
+                          element type
+
+  Errors in system calls throw std::system_error, with the errno;
+  a file that does not hold an A throws std::runtime_error.
+*/
+namespace array_nd
+{
+enum class file_layout { raw, header, npy };
+}
+
+namespace impl
+{
+// array_file_header describes the array following it in a file
+struct array_file_header
+{
+    static constexpr char magic_v[8] {'a','r','r','a','y','_','n','d'};
+    static constexpr uint32_t version_v = 1;
+    static constexpr size_t max_rank = 29;
+
+    char magic[8];
+    uint32_t version;
+    char kind;                // element_kind
+    char order;               // '<' little, '>' big endian
+    uint8_t element_size;
+    uint8_t rank;
+    uint64_t extents[max_rank];
+    uint64_t reserved;
+};
+static_assert(sizeof(array_file_header) == 256);
+
+// file_header<A>() the header for array A, of native byte order
+template <typename A>
+requires (std::rank_v<A> <= array_file_header::max_rank)
+array_file_header file_header() noexcept
+{
+    using T = std::remove_cv_t<std::remove_all_extents_t<A>>;
+    array_file_header h{};
+    std::memcpy(h.magic, h.magic_v, sizeof h.magic);
+    h.version = h.version_v;
+    h.kind = element_kind<T>();
+    h.order = std::endian::native == std::endian::little ? '<' : '>';
+    h.element_size = sizeof(T);
+    h.rank = std::rank_v<A>;
+    for (size_t d = 0; d != std::rank_v<A>; ++d)
+        h.extents[d] = extents<A>[d];
+    return h;
+}
+
+// check_file_header<A>(h) throws unless header h describes array A
+template <typename A>
+void check_file_header(array_file_header const& h)
+{
+    array_file_header const a = file_header<A>();
+    if (std::memcmp(h.magic, a.magic, sizeof a.magic) != 0
+     || h.version != a.version)
+        throw std::runtime_error("array_nd: not an array_nd file");
+    if (h.kind != a.kind || h.order != a.order
+     || h.element_size != a.element_size)
+        throw std::runtime_error("array_nd: file element type differs");
+    if (h.rank != a.rank
+     || std::memcmp(h.extents, a.extents, sizeof a.extents) != 0)
+        throw std::runtime_error("array_nd: file extents differ");
+}
+}
+
+namespace array_nd
+{
+template <typename A>
+requires std::is_array_v<A> && std::extent_v<A> != 0
+      && std::is_trivially_copyable_v<std::remove_all_extents_t<A>>
+class mapped_array
+{
+  public:
+    using array_type = A;
+    using element_type = std::remove_all_extents_t<A>;
+    static constexpr bool writable = !std::is_const_v<A>;
+
+    static mapped_array open(std::filesystem::path const& path,
+                             file_layout layout = file_layout::raw)
+    {
+        impl::file_descriptor f{::open(path.c_str(),
+                                       writable ? O_RDWR : O_RDONLY),
+                                "array_nd::mapped_array open"};
+        struct stat st;
+        if (::fstat(f.fd, &st) != 0)
+            impl::throw_errno("array_nd::mapped_array fstat");
+        size_t const size = size_t(st.st_size);
+        size_t off = offset(layout);
+        if (layout == file_layout::npy)
+        {
+            unsigned char pre[impl::npy_preamble_min];
+            size_t const n = ::pread(f.fd, pre, sizeof pre, 0) == sizeof pre
+                           ? impl::npy_preamble_bytes(pre, sizeof pre) : 0;
+            if (n == 0 || n > size)
+                throw std::runtime_error(
+                    "array_nd::mapped_array: not a .npy file");
+            off = n;
+            // other writers may pad the header less than to 64 bytes
+            if (off % alignof(element_type) != 0)
+                throw std::runtime_error(
+                    "array_nd::mapped_array: .npy payload is misaligned");
+        }
+        if (size != off + sizeof(A))
+            throw std::runtime_error(
+                "array_nd::mapped_array: file size differs from the array");
+        mapped_array m{f.fd, off};
+        if (layout == file_layout::header)
+            impl::check_file_header<A>(m.header());
+        if (layout == file_layout::npy)
+            impl::npy_payload_offset<A>(
+                static_cast<unsigned char const*>(m.base), off);
+        return m;
+    }
+
+    static mapped_array create(std::filesystem::path const& path,
+                               file_layout layout = file_layout::raw)
+    requires writable
+    {
+        impl::file_descriptor f{::open(path.c_str(),
+                                       O_RDWR | O_CREAT | O_TRUNC, 0666),
+                                "array_nd::mapped_array create"};
+        std::string const npy = layout == file_layout::npy
+                              ? impl::npy_header<A>() : std::string{};
+        size_t const off = offset(layout) + npy.size();
+        if (::ftruncate(f.fd, off_t(off + sizeof(A))) != 0)
+            impl::throw_errno("array_nd::mapped_array ftruncate");
+        mapped_array m{f.fd, off};
+        if (layout == file_layout::header)
+            m.header() = impl::file_header<A>();
+        std::memcpy(m.base, npy.data(), npy.size());
+        return m;
+    }
+
+    mapped_array(mapped_array&& o) noexcept
+      : base{std::exchange(o.base, nullptr)}, off{o.off} {}
+    mapped_array& operator=(mapped_array&& o) noexcept
+    {
+        std::swap(base, o.base);
+        std::swap(off, o.off);
+        return *this;
+    }
+    ~mapped_array() { if (base) ::munmap(base, off + sizeof(A)); }
+
+    operator array_nd_ref<A>() const noexcept { return ref(); }
+    array_nd_ref<A> ref() const noexcept { return {data()}; }
+    A& data() const noexcept {
+        return *std::launder(reinterpret_cast<A*>(
+                                 static_cast<char*>(base) + off));
+    }
+
+    void advise(int advice) const
+    {
+        if (::madvise(base, off + sizeof(A), advice) != 0)
+            impl::throw_errno("array_nd::mapped_array madvise");
+    }
+
+    void sync(bool wait = true) const requires writable
+    {
+        if (::msync(base, off + sizeof(A), wait ? MS_SYNC : MS_ASYNC) != 0)
+            impl::throw_errno("array_nd::mapped_array msync");
+    }
+
+  private:
+    static constexpr size_t offset(file_layout layout) noexcept {
+        return layout == file_layout::header
+             ? sizeof(impl::array_file_header) : 0;
+    }
+
+    // maps the whole file; the descriptor may then be closed
+    mapped_array(int fd, size_t o) : off{o}
+    {
+        int const prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+        base = ::mmap(nullptr, off + sizeof(A), prot, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED)
+            impl::throw_errno("array_nd::mapped_array mmap");
+    }
+    impl::array_file_header& header() const noexcept {
+        return *static_cast<impl::array_file_header*>(base);
+    }
+
+    void* base;
+    size_t off;
+};
+}
@@ -0,0 +1,265 @@
+//    Copyright (c) 2018 Will Wray https://keybase.io/willwray
+//
+//   Distributed under the Boost Software License, Version 1.0.
+//          (http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <bit>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "array_nd_posix.hpp"
+#include "array_nd_ref.hpp"
+
+/*
+   "array_nd_npy.hpp"
+    ^^^^^^^^^^^^^^^^
+    NumPy .npy files of C-arrays and array_nd_refs (POSIX).
+
+  Usage:
+      float grid[480][640];
+      array_nd::write_npy("grid.npy", grid);   // np.load("grid.npy")
+      array_nd::read_npy("grid.npy", array_nd_ref{grid});
+
+      // or, zero-copy, see "array_nd_mmap.hpp"
+      auto m = array_nd::mapped_array<float const[480][640]>::open(
+                                   "grid.npy", array_nd::file_layout::npy);
+
+  Functions, in namespace array_nd:
+    write_npy(path, x)    writes the .npy header then the payload of x,
+                          in one vectored write
+    read_npy(path, dst)   reads a .npy file into dst, streaming
+
+  The header dtype and shape must match the element type and extents
+  of dst: dtype by kind, size and byte order, e.g. '<f4' for float on
+  a little-endian host, and shape by rank and each std::extent_v, in
+  C order; fortran_order files are not accepted.
+  Headers of format version 1.0 are written, with the payload aligned
+  to 64 bytes; versions 1.0, 2.0 and 3.0 are read.
+  Element types are bool, arithmetic ('b','i','u','f' kinds) or other
+  trivially copyable types, as void 'V' of their size.
+
+  Errors in system calls throw std::system_error, with the errno;
+  a file that does not match dst throws std::runtime_error.
+*/
+namespace impl
+{
+// element_kind<T>() NumPy-style kind code of element type T
+// 'b' bool, 'i' signed, 'u' unsigned integer, 'f' floating, else 'V'
+template <typename T>
+constexpr char element_kind() noexcept
+{
+    if constexpr (std::is_same_v<T,bool>)
+        return 'b';
+    else if constexpr (std::is_floating_point_v<T>)
+        return 'f';
+    else if constexpr (std::is_integral_v<T>)
+        return std::is_signed_v<T> ? 'i' : 'u';
+    else
+        return 'V';
+}
+
+inline constexpr char npy_magic[] = "\x93NUMPY";
+inline constexpr size_t npy_align = 64;
+
+// npy_descr<T>() the dtype descr of T, e.g. "<f4", "|u1", "|V12"
+template <typename T>
+std::string npy_descr()
+{
+    char const order = sizeof(T) == 1 || element_kind<T>() == 'V' ? '|'
+                     : std::endian::native == std::endian::little ? '<' : '>';
+    return order + (element_kind<T>() + std::to_string(sizeof(T)));
+}
+
+// npy_header<A>() the .npy version 1.0 header of array A, padded with
+// spaces and a newline so the payload follows at a multiple of 64
+template <typename A>
+std::string npy_header()
+{
+    using T = std::remove_cv_t<std::remove_all_extents_t<A>>;
+    std::string d = "{'descr': '" + npy_descr<T>()
+                  + "', 'fortran_order': False, 'shape': (";
+    for (size_t e : extents<A>)
+        d += std::to_string(e) + ", ";
+    if (std::rank_v<A> > 1)
+        d.resize(d.size() - 1);         // (2, 3) but (2,)
+    d.back() = ')';
+    d += ", }";
+    size_t const pre = sizeof npy_magic - 1 + 2 + 2;
+    d.append(npy_align - 1 - (pre + d.size()) % npy_align, ' ');
+    d += '\n';
+    std::string h(npy_magic, sizeof npy_magic - 1);
+    h += '\x01';
+    h += '\x00';
+    h += char(d.size() & 0xff);
+    h += char(d.size() >> 8);
+    return h + d;
+}
+
+// npy_preamble_bytes(p,n) total header size from the first n bytes at p,
+// n >= npy_preamble_min, or 0 if they are not a .npy preamble
+inline constexpr size_t npy_preamble_min = 12;
+inline size_t npy_preamble_bytes(unsigned char const* p, size_t n) noexcept
+{
+    if (n < npy_preamble_min
+     || std::memcmp(p, npy_magic, sizeof npy_magic - 1) != 0)
+        return 0;
+    if (p[6] == 1)
+        return 10 + (p[8] | size_t{p[9]} << 8);
+    if (p[6] == 2 || p[6] == 3)
+        return 12 + (p[8] | size_t{p[9]} << 8 | size_t{p[10]} << 16
+                          | size_t{p[11]} << 24);
+    return 0;
+}
+
+// npy_value(dict, key) the text of the value of key in the header dict;
+// the dict is from the file, so a malformed one throws
+inline std::string_view npy_value(std::string_view dict, std::string_view key)
+{
+    auto const malformed = [] {
+        return std::runtime_error("array_nd npy: malformed header");
+    };
+    for (char q : {'\'', '"'})
+    {
+        std::string k = q + std::string(key) + q;
+        if (auto i = dict.find(k); i != dict.npos)
+        {
+            i = dict.find(':', i + k.size());
+            if (i != dict.npos)
+                i = dict.find_first_not_of(' ', i + 1);
+            if (i == dict.npos)
+                throw malformed();
+            char const c = dict[i];
+            bool const quoted = c == '\'' || c == '"';
+            auto const e = c == '(' ? dict.find(')', i)
+                         : quoted ? dict.find(c, i + 1)
+                         : dict.find_first_of(",}", i);
+            if (e == dict.npos)
+                throw malformed();
+            return dict.substr(i, e - i + (c == '(' || quoted));
+        }
+    }
+    throw std::runtime_error("array_nd npy: header lacks "
+                             + std::string(key));
+}
+
+// check_npy_header<A>(dict) throws unless .npy header dict matches A
+template <typename A>
+void check_npy_header(std::string_view dict)
+{
+    using T = std::remove_cv_t<std::remove_all_extents_t<A>>;
+    auto descr = npy_value(dict, "descr");
+    if (descr.size() < 2)
+        throw std::runtime_error("array_nd npy: malformed header");
+    descr = descr.substr(1, descr.size() - 2);
+    std::string const want = npy_descr<T>();
+    if (descr.size() != want.size()
+     || descr.substr(1) != std::string_view(want).substr(1)
+     || (descr[0] != want[0] && descr[0] != '=' && sizeof(T) != 1
+                             && descr[0] != '|'))
+        throw std::runtime_error("array_nd npy: dtype " + std::string(descr)
+                                 + " differs from " + want);
+    if (npy_value(dict, "fortran_order") != "False")
+        throw std::runtime_error("array_nd npy: fortran_order unsupported");
+    std::string_view shape = npy_value(dict, "shape");
+    for (size_t e : extents<A>)
+    {
+        auto const i = shape.find_first_of("0123456789");
+        if (i == shape.npos)
+            throw std::runtime_error("array_nd npy: shape rank differs");
+        size_t n = 0, j = i;
+        for (; j != shape.size() && shape[j] >= '0' && shape[j] <= '9'; ++j)
+            n = n * 10 + size_t(shape[j] - '0');
+        if (n != e)
+            throw std::runtime_error("array_nd npy: shape extents differ");
+        shape.remove_prefix(j);
+    }
+    if (shape.find_first_of("0123456789") != shape.npos)
+        throw std::runtime_error("array_nd npy: shape rank differs");
+}
+
+// npy_payload_offset<A>(p,n) parses and checks the .npy header at p,
+// of which n bytes are available, and returns the payload offset
+template <typename A>
+size_t npy_payload_offset(unsigned char const* p, size_t n)
+{
+    size_t const h = npy_preamble_bytes(p, n);
+    if (h == 0)
+        throw std::runtime_error("array_nd npy: not a .npy file");
+    if (h > n)
+        throw std::runtime_error("array_nd npy: truncated header");
+    size_t const pre = p[6] == 1 ? 10 : 12;
+    check_npy_header<A>({reinterpret_cast<char const*>(p) + pre, h - pre});
+    return h;
+}
+}
+
+namespace array_nd
+{
+template <typename X>
+requires (std::is_array_v<X> || is_array_nd_ref_v<X>)
+      && std::is_trivially_copyable_v<remove_all_extents_t<X>>
+void write_npy(std::filesystem::path const& path, X const& x)
+{
+    using A = typename decltype(array_nd_ref{x})::array_type;
+    auto const r = array_nd_ref{x};
+    std::string const h = impl::npy_header<A>();
+    impl::file_descriptor f{::open(path.c_str(),
+                                   O_WRONLY | O_CREAT | O_TRUNC, 0666),
+                            "array_nd write_npy open"};
+    iovec v[2] {{const_cast<char*>(h.data()), h.size()},
+                {const_cast<void*>(static_cast<void const*>(
+                     impl::flat(r.a))), sizeof(A)}};
+    iovec* iv = v;
+    int cnt = 2;
+    while (cnt != 0)
+    {
+        ssize_t w = ::writev(f.fd, iv, cnt);
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w < 0)
+            impl::throw_errno("array_nd write_npy writev");
+        // partial write: advance past the bytes written
+        for (; cnt != 0 && size_t(w) >= iv->iov_len; ++iv, --cnt)
+            w -= ssize_t(iv->iov_len);
+        if (cnt != 0)
+        {
+            iv->iov_base = static_cast<char*>(iv->iov_base) + w;
+            iv->iov_len -= size_t(w);
+        }
+    }
+}
+
+template <typename A>
+requires std::is_trivially_copyable_v<std::remove_all_extents_t<A>>
+      && (!std::is_const_v<A>)
+void read_npy(std::filesystem::path const& path, array_nd_ref<A> dst)
+{
+    impl::file_descriptor f{::open(path.c_str(), O_RDONLY),
+                            "array_nd read_npy open"};
+    std::string h(impl::npy_preamble_min, '\0');
+    auto const p = [&] { return reinterpret_cast<unsigned char*>(h.data()); };
+    impl::read_fully(f.fd, p(), h.size(), "array_nd read_npy");
+    size_t const n = impl::npy_preamble_bytes(p(), h.size());
+    if (n > h.size())
+    {
+        h.resize(n);
+        impl::read_fully(f.fd, p() + impl::npy_preamble_min,
+                         n - impl::npy_preamble_min, "array_nd read_npy");
+    }
+    size_t const off = impl::npy_payload_offset<A>(p(), h.size());
+    if (::lseek(f.fd, off_t(off), SEEK_SET) < 0)
+        impl::throw_errno("array_nd read_npy lseek");
+    impl::read_fully(f.fd, impl::flat(dst.a), sizeof(A), "array_nd read_npy");
+}
+}
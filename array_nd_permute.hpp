@@ -0,0 +1,200 @@
+//    Copyright (c) 2018 Will Wray https://keybase.io/willwray
+//
+//   Distributed under the Boost Software License, Version 1.0.
+//          (http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+
+#include "array_nd_expr.hpp"
+#include "array_nd_transpose.hpp"
+
+/*
+   "array_nd_permute.hpp"
+    ^^^^^^^^^^^^^^^^^^^^
+    Lazy axis-permuted view of an array_nd_ref, any rank.
+
+  Usage:
+      float x[8][16][32], y[32][8][16];
+      auto v = array_nd::permute<2,0,1>(array_nd_ref{x});
+      v(i,j,k) == x[j][k][i];              // v's extents are 32, 8, 16
+      array_nd_ref{y} = v;                 // materialize, cache-blocked
+      array_nd_ref{y} = v * 2.f + 1.f;     // or as expression operand
+
+  permute<Axes...>(x) -> impl::expr_permuted<A, Axes...>
+    Dimension d of the view is dimension Axes[d] of x; Axes... must be
+    a permutation of 0...rank-1, checked at compile time, as are the
+    view's extents. No element is touched until the view is read.
+    The view is an expression, see "array_nd_expr.hpp", so it may be
+    deep-assigned to an array_nd_ref of its shape or be an operand.
+
+  Materialization:
+    Assignment of a bare view copies with contiguous runs on both sides:
+    if the innermost axis is kept, row by row; otherwise, for each index
+    of the other axes, the 2D slice spanned by the innermost axes of the
+    source and of the destination is a strided transpose, which is done
+    by the cache-oblivious, register-tiled kernel of "array_nd_transpose".
+    The destination must not overlap the source.
+*/
+namespace impl
+{
+// is_permutation<R>(axes) axes is a permutation of 0...R-1
+template <size_t R>
+constexpr bool is_permutation(std::array<size_t,R> axes)
+{
+    std::array<bool,R> seen{};
+    for (size_t x : axes)
+    {
+        if (x >= R || seen[x])
+            return false;
+        seen[x] = true;
+    }
+    return true;
+}
+
+// expr_permuted<A,Axes...> permuted view of A, an expression node
+template <typename A, size_t... Axes>
+requires std::is_array_v<A> && (sizeof...(Axes) == std::rank_v<A>)
+      && (is_permutation<sizeof...(Axes)>({Axes...}))
+struct expr_permuted
+{
+    using source_type  = A;
+    using element_type = std::remove_all_extents_t<A>;
+    using value_type   = std::remove_cv_t<element_type>;
+
+    static constexpr size_t rank = sizeof...(Axes);
+    static constexpr std::array<size_t,rank> axes {Axes...};
+
+    // view extents, and source strides of each view dimension
+    static constexpr std::array<size_t,rank> extents {
+        std::extent_v<A,Axes>... };
+    static constexpr std::array<size_t,rank> strides {
+        impl::strides<A>[Axes]... };
+
+    using array_type = array_from_t<value_type, extents>;
+    static constexpr bool dense = false;
+
+    std::remove_extent_t<A>* a;
+
+    // (i...) full multi-index into the view
+    template <typename... I>
+    requires (sizeof...(I) == rank) && (std::is_convertible_v<I,size_t> && ...)
+    constexpr element_type& operator()(I... i) const
+    {
+        return element(a, [=]<size_t... D>(std::index_sequence<D...>) {
+            return (... + (size_t(i) * strides[D]));
+        }(std::make_index_sequence<rank>{}));
+    }
+
+    // row<RX>(k) expression row access, see "array_nd_expr.hpp"
+    template <size_t S>
+    struct row_type
+    {
+        std::remove_extent_t<A>* a;
+        size_t f;
+        constexpr value_type operator[](size_t j) const {
+            return element(a, f + j*S);
+        }
+    };
+    template <auto RX>
+    constexpr auto row(size_t k) const
+    {
+        constexpr size_t r = RX.size(), s = rank;
+        size_t f = 0;
+        for (size_t d = r-1; d-- != 0; )
+        {
+            size_t const i = k % RX[d];
+            k /= RX[d];
+            if (d >= r - s && extents[d-(r-s)] != 1)
+                f += i * strides[d-(r-s)];
+        }
+        if constexpr (extents[s-1] != 1)
+            return row_type<strides[s-1]>{a, f};
+        else
+            return expr_scalar<value_type>{element(a, f)};
+    }
+};
+}
+
+namespace array_nd
+{
+template <typename A, size_t... Axes>
+inline constexpr bool is_expr_v<impl::expr_permuted<A,Axes...>> = true;
+
+// permute<Axes...>(x) lazy view of x with dimension d its Axes[d]
+template <size_t... Axes, typename A>
+requires (sizeof...(Axes) == std::rank_v<A>)
+      && (impl::is_permutation<sizeof...(Axes)>({Axes...}))
+constexpr impl::expr_permuted<A,Axes...> permute(array_nd_ref<A> x) noexcept
+{
+    return {x.a};
+}
+}
+
+namespace impl
+{
+// expr_assign(x,v) materializes permuted view v into x, blocked,
+// overloading the element-wise expression evaluation; for the same
+// element type only, others convert element-wise
+template <typename B, typename A, size_t... Axes>
+requires std::is_same_v<std::remove_cv_t<std::remove_all_extents_t<A>>,
+                        std::remove_cv_t<std::remove_all_extents_t<B>>>
+constexpr void expr_assign(array_nd_ref<B> x,
+                           expr_permuted<A,Axes...> const& v)
+{
+    using V = expr_permuted<A,Axes...>;
+    constexpr size_t r = V::rank;
+    static_assert(same_extents<typename V::array_type,
+                               std::remove_cv_t<B>>(),
+                  "array_nd permuted view shape differs from destination");
+    constexpr auto& ext = V::extents;
+    constexpr auto& src = V::strides;
+    constexpr auto& dst = strides<std::remove_cv_t<B>>;
+    constexpr size_t n = array_size<B>;
+
+    if (std::is_constant_evaluated())
+    {
+        for (size_t i = 0; i != n; ++i)
+        {
+            size_t f = 0, k = i;
+            for (size_t d = r; d-- != 0; )
+            {
+                f += k % ext[d] * src[d];
+                k /= ext[d];
+            }
+            element(x.a, i) = element(v.a, f);
+        }
+        return;
+    }
+    auto* s = flat(v.a);
+    auto* p = flat(x.a);
+    // q the view dimension that is the source's innermost, stride 1
+    constexpr size_t q = [] {
+        size_t q = 0;
+        while (V::axes[q] != r-1)
+            ++q;
+        return q;
+    }();
+    // the outer dimensions, all but q and r-1, odometer order
+    constexpr size_t m = n / ext[r-1] / (q == r-1 ? 1 : ext[q]);
+    for (size_t o = 0; o != m; ++o)
+    {
+        size_t fs = 0, fd = 0, k = o;
+        for (size_t d = r-1; d-- != 0; )
+            if (d != q)
+            {
+                size_t const i = k % ext[d];
+                k /= ext[d];
+                fs += i * src[d];
+                fd += i * dst[d];
+            }
+        if constexpr (q == r-1)
+            std::copy_n(s + fs, ext[r-1], p + fd);
+        else
+            transpose_rect(s + fs, src[r-1], p + fd, dst[q],
+                           0, ext[r-1], 0, ext[q]);
+    }
+}
+}
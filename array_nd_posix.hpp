@@ -0,0 +1,67 @@
+//    Copyright (c) 2018 Will Wray https://keybase.io/willwray
+//
+//   Distributed under the Boost Software License, Version 1.0.
+//          (http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <unistd.h>
+
+/*
+   "array_nd_posix.hpp"
+    ^^^^^^^^^^^^^^^^^^
+    POSIX helpers shared by the file and shared memory headers,
+    "array_nd_npy.hpp", "array_nd_mmap.hpp", "array_nd_io.hpp"
+    and "array_nd_shm.hpp".
+
+  In namespace impl:
+    throw_errno(what)          throws std::system_error for errno
+    file_descriptor{fd, what}  owns fd, closed at scope exit;
+                               throws for a negative fd
+    read_fully(fd, p, n, what) reads n bytes, retrying on EINTR;
+                               throws std::runtime_error at end of file
+*/
+namespace impl
+{
+// throw_errno(what) throws std::system_error for the current errno
+[[noreturn]] inline void throw_errno(char const* what)
+{
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+// file_descriptor closes fd at scope exit
+struct file_descriptor
+{
+    int fd;
+    explicit file_descriptor(int f, char const* what) : fd{f} {
+        if (fd < 0)
+            throw_errno(what);
+    }
+    file_descriptor(file_descriptor const&) = delete;
+    ~file_descriptor() { ::close(fd); }
+};
+
+// read_fully(fd,p,n) reads n bytes, throws on error or end of file
+inline void read_fully(int fd, void* p, size_t n, char const* what)
+{
+    auto b = static_cast<char*>(p);
+    while (n != 0)
+    {
+        ssize_t const r = ::read(fd, b, n);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r < 0)
+            throw_errno(what);
+        if (r == 0)
+            throw std::runtime_error(std::string(what) + ": end of file");
+        b += r;
+        n -= size_t(r);
+    }
+}
+}
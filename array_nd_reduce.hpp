@@ -0,0 +1,402 @@
+//    Copyright (c) 2018 Will Wray https://keybase.io/willwray
+//
+//   Distributed under the Boost Software License, Version 1.0.
+//          (http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include "array_nd_ref.hpp"
+
+/*
+   "array_nd_reduce.hpp"
+    ^^^^^^^^^^^^^^^^^^^
+    Reductions over all elements of a C-array or array_nd_ref, as-if flat.
+
+  Usage:
+      float img[1024][1024];
+      float total = array_nd::sum(img);
+      auto [lo, hi] = array_nd::minmax(array_nd_ref{img});
+      double t = array_nd::sum(img, 0.0);   // accumulate in double
+
+  Functions, in namespace array_nd:
+    reduce(x, init, op)  op-fold of init and all elements of x
+    sum(x, init = 0)     init + x...
+    product(x, init = 1) init * x...
+    min(x), max(x)       least, greatest element, by <
+    minmax(x)            pair {min(x), max(x)}, in one pass
+
+  Along one axis K, into dst of the shape of x with axis K removed,
+  remove_axis_t<A,K> (see "traits.hpp"), checked at compile time:
+      float act[32][64][64], mean[64][64];   // per-batch statistics
+      array_nd::sum_axis<0>(act, array_nd_ref{mean});
+      int idx[32][64];
+      array_nd::argmax_axis<2>(act, array_nd_ref{idx});
+
+    reduce_axis<K>(x, dst, op)  op-fold of the elements along axis K
+    sum_axis<K>(x, dst), max_axis<K>(x, dst)
+    argmax_axis<K>(x, dst)      index along K of the first greatest element
+
+  Axis reductions stream x in memory order: x is viewed as [O][N][I],
+  N the extent of axis K, and each run of I contiguous elements is folded
+  element-wise into a dst row held in L1, in blocks if I is large;
+  for the innermost axis, I == 1, each run of N is reduced as above.
+
+  As for std::reduce, op must be associative and commutative, since
+  elements are combined out of order: at runtime each reduction keeps
+  several independent accumulators over the flat element range, to hide
+  op latency, combined pairwise at the end. For arithmetic elements and
+  an op that also applies to GCC vector types, as do std::plus<> and
+  generic lambdas, the accumulators are SIMD vectors.
+  Floating point results may then differ in rounding from a serial sum.
+  In constant evaluation the reduction is a serial left fold.
+*/
+namespace impl
+{
+// simd<T> GCC vector of T, one native register, AVX or else SSE width
+#ifdef __AVX__
+inline constexpr size_t simd_bytes = 32;
+#else
+inline constexpr size_t simd_bytes = 16;
+#endif
+template <typename T>
+struct simd
+{
+    typedef T type __attribute__((vector_size(simd_bytes)));
+};
+template <typename T>
+using simd_t = typename simd<T>::type;
+
+// simd_reducible<T,Op> op applies lane-wise to simd vectors of T,
+// e.g. std::plus<> or a generic lambda, not one that takes T params
+template <typename T, typename Op>
+concept bool simd_reducible = std::is_arithmetic_v<T>
+                          && !std::is_same_v<T,bool>
+                          && std::is_invocable_r_v<simd_t<T>, Op,
+                                                   simd_t<T>, simd_t<T>>;
+
+// reduce_lanes independent accumulators hide op latency;
+// they are combined pairwise at the end
+inline constexpr size_t reduce_lanes = 8;
+
+// reduce_flat(p,n,init,op) multi-accumulator reduction of n elements at p
+template <typename Acc, typename T, typename Op>
+Acc reduce_flat(T const* p, size_t n, Acc init, Op op)
+{
+    constexpr size_t L = reduce_lanes;
+    size_t i = 0;
+    if constexpr (std::is_same_v<Acc,T> && simd_reducible<T,Op>)
+    {
+        using V = simd_t<T>;
+        constexpr size_t W = sizeof(V) / sizeof(T);
+        if (n >= 2*L*W)
+        {
+            V a[L];
+            std::memcpy(a, p, sizeof a);
+            for (i = L*W; i != n - n % (L*W); i += L*W)
+#pragma GCC unroll 8
+                for (size_t l = 0; l != L; ++l)
+                {
+                    V v;
+                    std::memcpy(&v, p + i + l*W, sizeof v);
+                    a[l] = op(a[l], v);
+                }
+            for (size_t w = L/2; w != 0; w /= 2)
+                for (size_t l = 0; l != w; ++l)
+                    a[l] = op(a[l], a[l+w]);
+            for (size_t l = 0; l != W; ++l)
+                init = op(init, a[0][l]);
+        }
+    }
+    else if (n >= 2*L)
+    {
+        Acc a[L];
+        for (size_t l = 0; l != L; ++l)
+            a[l] = static_cast<Acc>(p[l]);
+        for (i = L; i != n - n % L; i += L)
+#pragma GCC unroll 8
+            for (size_t l = 0; l != L; ++l)
+                a[l] = op(a[l], p[i+l]);
+        for (size_t w = L/2; w != 0; w /= 2)
+            for (size_t l = 0; l != w; ++l)
+                a[l] = op(a[l], a[l+w]);
+        init = op(init, a[0]);
+    }
+    for (; i < n; ++i)
+        init = op(init, p[i]);
+    return init;
+}
+
+// as_ref(x) array_nd_ref view of C-array or array_nd_ref x
+template <typename X>
+constexpr auto as_ref(X const& x) noexcept
+{
+    if constexpr (std::is_array_v<X>)
+        return array_nd_ref<X const>{x};
+    else
+        return x;
+}
+template <typename X>
+concept bool array_or_ref = std::is_array_v<X> || is_array_nd_ref_v<X>;
+
+// min_op, max_op select as std::min, std::max, also lane-wise on simd;
+// mixed types, as an accumulator and an element, give the common type
+struct min_op
+{
+    template <typename T, typename U>
+    constexpr std::common_type_t<T,U>
+    operator()(T const& a, U const& b) const {
+        return b < a ? b : a;
+    }
+};
+struct max_op
+{
+    template <typename T, typename U>
+    constexpr std::common_type_t<T,U>
+    operator()(T const& a, U const& b) const {
+        return a < b ? b : a;
+    }
+};
+
+// ref_array_t<X> the array type, less cv, of C-array or array_nd_ref X
+template <typename X>
+using ref_array_t = typename decltype(as_ref(std::declval<X const&>()))
+                    ::array_type;
+
+// axis_dst<A,K,D> dst array D is of the shape of A less its axis K,
+// of any element type; reduction along the one axis of a 1D array
+// is whole-array reduction
+template <typename A, size_t K, typename D>
+concept bool axis_dst = (K < std::rank_v<A>) && (std::rank_v<A> > 1)
+                     && same_extents<remove_axis_t<A,K>, D>();
+
+// axis_block_bytes size of a dst row block, to stay in L1
+// with its source run as the block is folded over N source rows
+inline constexpr size_t axis_block_bytes = 8192;
+
+// reduce_axis(s,d,O,N,I,op) folds s viewed as [O][N][I] along N into d
+template <typename T, typename Acc, typename Op>
+void reduce_axis(T const* s, Acc* d, size_t O, size_t N, size_t I, Op op)
+{
+    if (I == 1)
+    {
+        for (size_t o = 0; o != O; ++o, s += N)
+            d[o] = reduce_flat(s + 1, N - 1, static_cast<Acc>(s[0]), op);
+        return;
+    }
+    constexpr size_t C = axis_block_bytes / sizeof(Acc);
+    for (size_t o = 0; o != O; ++o, s += N*I, d += I)
+        for (size_t i0 = 0; i0 < I; i0 += C)
+        {
+            size_t const c = std::min(C, I - i0);
+            T const* r = s + i0;
+            Acc* __restrict__ a = d + i0;
+            for (size_t i = 0; i != c; ++i)
+                a[i] = static_cast<Acc>(r[i]);
+            for (size_t n = 1; n != N; ++n)
+            {
+                r += I;
+#pragma GCC ivdep
+                for (size_t i = 0; i != c; ++i)
+                    a[i] = op(a[i], r[i]);
+            }
+        }
+}
+
+// argmax_axis(s,d,O,N,I) index along N of the first greatest element
+template <typename T, typename Ix>
+void argmax_axis(T const* s, Ix* d, size_t O, size_t N, size_t I)
+{
+    if (I == 1)
+    {
+        for (size_t o = 0; o != O; ++o, s += N)
+        {
+            size_t m = 0;
+            for (size_t n = 1; n != N; ++n)
+                if (s[m] < s[n])
+                    m = n;
+            d[o] = static_cast<Ix>(m);
+        }
+        return;
+    }
+    constexpr size_t C = axis_block_bytes / sizeof(T);
+    T best[C];
+    for (size_t o = 0; o != O; ++o, s += N*I, d += I)
+        for (size_t i0 = 0; i0 < I; i0 += C)
+        {
+            size_t const c = std::min(C, I - i0);
+            T const* r = s + i0;
+            Ix* __restrict__ a = d + i0;
+            for (size_t i = 0; i != c; ++i)
+            {
+                best[i] = r[i];
+                a[i] = 0;
+            }
+            for (size_t n = 1; n != N; ++n)
+            {
+                r += I;
+#pragma GCC ivdep
+                for (size_t i = 0; i != c; ++i)
+                {
+                    bool const g = best[i] < r[i];
+                    best[i] = g ? r[i] : best[i];
+                    a[i] = g ? static_cast<Ix>(n) : a[i];
+                }
+            }
+        }
+}
+
+// axis_fold<K>(x,f) constant-evaluable fold along axis K:
+// f(j,n,v) is called for each dst flat index j, index n along K
+// and element v, in order of n
+template <size_t K, typename A, typename F>
+constexpr void axis_fold(array_nd_ref<A> x, F f)
+{
+    constexpr size_t N = std::extent_v<A,K>, I = strides<A>[K];
+    constexpr size_t O = array_size<A> / (N*I);
+    for (size_t o = 0; o != O; ++o)
+        for (size_t n = 0; n != N; ++n)
+            for (size_t i = 0; i != I; ++i)
+                f(o*I + i, n, element(x.a, (o*N + n)*I + i));
+}
+}
+
+namespace array_nd
+{
+template <typename X, typename Acc, typename Op>
+requires impl::array_or_ref<X>
+constexpr Acc reduce(X const& x, Acc init, Op op)
+{
+    auto e = impl::as_ref(x).elements();
+    if (std::is_constant_evaluated())
+    {
+        for (auto const& v : e)
+            init = op(init, v);
+        return init;
+    }
+    return impl::reduce_flat(e.data(), e.size(), init, op);
+}
+
+template <typename X,
+          typename Acc = std::remove_cv_t<remove_all_extents_t<X>>>
+requires impl::array_or_ref<X>
+constexpr Acc sum(X const& x, Acc init = Acc(0))
+{
+    return reduce(x, init, std::plus<>{});
+}
+
+template <typename X,
+          typename Acc = std::remove_cv_t<remove_all_extents_t<X>>>
+requires impl::array_or_ref<X>
+constexpr Acc product(X const& x, Acc init = Acc(1))
+{
+    return reduce(x, init, std::multiplies<>{});
+}
+
+template <typename X>
+requires impl::array_or_ref<X>
+constexpr auto min(X const& x)
+{
+    auto e = impl::as_ref(x).elements();
+    return reduce(x, e[0], impl::min_op{});
+}
+
+template <typename X>
+requires impl::array_or_ref<X>
+constexpr auto max(X const& x)
+{
+    auto e = impl::as_ref(x).elements();
+    return reduce(x, e[0], impl::max_op{});
+}
+
+template <typename X>
+requires impl::array_or_ref<X>
+constexpr auto minmax(X const& x)
+{
+    auto e = impl::as_ref(x).elements();
+    using T = std::remove_cv_t<remove_all_extents_t<X>>;
+    std::pair<T,T> r{e[0], e[0]};
+    if (std::is_constant_evaluated())
+    {
+        for (auto const& v : e)
+            r = {impl::min_op{}(r.first, v), impl::max_op{}(r.second, v)};
+        return r;
+    }
+    // one pass through memory: min then max of each L1-resident block
+    constexpr size_t B = 16384 / sizeof(T);
+    T const* p = e.data();
+    size_t const n = e.size();
+    for (size_t i = 0; i < n; i += B)
+    {
+        size_t const m = std::min(B, n - i);
+        r.first = impl::reduce_flat(p + i, m, r.first, impl::min_op{});
+        r.second = impl::reduce_flat(p + i, m, r.second, impl::max_op{});
+    }
+    return r;
+}
+
+template <size_t K, typename X, typename D, typename Op>
+requires impl::array_or_ref<X> && impl::axis_dst<impl::ref_array_t<X>,K,D>
+constexpr void reduce_axis(X const& x, array_nd_ref<D> dst, Op op)
+{
+    using A = impl::ref_array_t<X>;
+    using Acc = std::remove_all_extents_t<D>;
+    auto r = impl::as_ref(x);
+    if (std::is_constant_evaluated())
+    {
+        impl::axis_fold<K>(r, [&](size_t j, size_t n, auto const& v) {
+            Acc& d = impl::element(dst.a, j);
+            d = n ? op(d, v) : static_cast<Acc>(v);
+        });
+        return;
+    }
+    constexpr size_t N = std::extent_v<A,K>, I = impl::strides<A>[K];
+    impl::reduce_axis(impl::flat(r.a), impl::flat(dst.a),
+                      array_size<A> / (N*I), N, I, op);
+}
+
+template <size_t K, typename X, typename D>
+requires impl::array_or_ref<X> && impl::axis_dst<impl::ref_array_t<X>,K,D>
+constexpr void sum_axis(X const& x, array_nd_ref<D> dst)
+{
+    reduce_axis<K>(x, dst, std::plus<>{});
+}
+
+template <size_t K, typename X, typename D>
+requires impl::array_or_ref<X> && impl::axis_dst<impl::ref_array_t<X>,K,D>
+constexpr void max_axis(X const& x, array_nd_ref<D> dst)
+{
+    reduce_axis<K>(x, dst, impl::max_op{});
+}
+
+template <size_t K, typename X, typename D>
+requires impl::array_or_ref<X> && impl::axis_dst<impl::ref_array_t<X>,K,D>
+      && std::is_integral_v<std::remove_all_extents_t<D>>
+constexpr void argmax_axis(X const& x, array_nd_ref<D> dst)
+{
+    using A = impl::ref_array_t<X>;
+    using Ix = std::remove_all_extents_t<D>;
+    auto r = impl::as_ref(x);
+    if (std::is_constant_evaluated())
+    {
+        // dst holds indices, so the running max is re-read from x
+        constexpr size_t N = std::extent_v<A,K>, I = impl::strides<A>[K];
+        impl::axis_fold<K>(r, [&](size_t j, size_t n, auto const& v) {
+            Ix& d = impl::element(dst.a, j);
+            if (n == 0)
+                d = 0;
+            else if (impl::element(r.a, (j/I*N + size_t(d))*I + j%I) < v)
+                d = static_cast<Ix>(n);
+        });
+        return;
+    }
+    constexpr size_t N = std::extent_v<A,K>, I = impl::strides<A>[K];
+    impl::argmax_axis(impl::flat(r.a), impl::flat(dst.a),
+                      array_size<A> / (N*I), N, I);
+}
+}
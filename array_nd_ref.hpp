@@ -6,9 +6,12 @@
 
 #pragma once
 
-//#include <algorithm>
+#include <algorithm>
 #include <array>
-//#include <iterator>
+#include <compare>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
 
 #include "traits.hpp"
 
@@ -46,7 +49,10 @@
 //    Copy semantics, including copy-list assignment, fill and swap.
 //    Iterator interface.
 //    Tuple interface -> unpacks via structured binding.
-//    Comparison operators; < is lexicographic compare as-if a flat array.
+//    Comparison operators; <=> is lexicographic compare as-if a flat array
+//    and the relational operators are all routed through <=>.
+//    mismatch(x,y) locates the first differing element, flat and nd index.
+//    reshape<B>(x) views the same elements as another shape B, no copy.
 
 // Unlike std::array:
 //    It is a non-owning view type, so user beware dangling references.
@@ -58,11 +64,15 @@
 //    The template signature is <A> rather than <T,size_t...>
 //    There's no zero-size specialization (there's no zero size C array).
 //    Copy assign and comparisons enabled for C array rhs, constexpr.
+//    Deep assign from element-wise expressions, see "array_nd_expr.hpp".
 
 // Indexing and iterating:
 //    Iterators are raw pointer-to-array
+//    elements() is a flat range over all elements, contiguous iterator
 //    Index operator[] returns builtin C subarray&
 //    Index operator() returns ref-wrapped subarray for rank > 1
+//    Multi-index operator()(i,j,k...) (and operator[] in C++23) computes
+//    a single flat offset from compile-time strides for a full index
 
 // Constness
 //    The constness of array_nd_ref{arr} reflects the constness of arr,
@@ -91,6 +101,262 @@
 // Code generation in practice is less optimal for hierarchical access
 // than for flat iteration.
 //
+// Runtime fast paths:
+// Where it pays, operations test std::is_constant_evaluated() and, at
+// runtime, treat the whole array as one flat block of elements.
+// The recursive hierarchical path is kept for constant evaluation.
+// elements() exposes this as a flat range with contiguous iterator;
+// its element access is a raw pointer offset at runtime and hierarchical
+// indexing in constant evaluation.
+//
+namespace impl
+{
+// flat(p) returns pointer to first element of the array that p points to,
+// by successive array-to-pointer decay rather than reinterpret_cast.
+// Arithmetic on the result beyond the first innermost subarray is not a
+// constant expression, so use the result only when not constant evaluated.
+template <typename T>
+constexpr auto flat(T* p) noexcept
+{
+    if constexpr (std::is_array_v<T>)
+        return flat(*p);
+    else
+        return p;
+}
+
+// strides<A> the number of elements spanned by a unit index step
+// in each dimension of row-major array A; strides<A>[rank-1] == 1
+template <typename A>
+constexpr auto make_strides() noexcept
+{
+    std::array<size_t, std::rank_v<A>> s{};
+    size_t n = array_size<A>;
+    [&]<size_t... D>(std::index_sequence<D...>) {
+        ((s[D] = n /= std::extent_v<A,D>), ...);
+    }(std::make_index_sequence<std::rank_v<A>>{});
+    return s;
+}
+template <typename A>
+inline constexpr auto strides = make_strides<A>();
+
+// extents<A> std::array of the extents of array A
+template <typename A>
+inline constexpr auto extents = []<size_t... D>(std::index_sequence<D...>) {
+    return std::array<size_t, std::rank_v<A>>{std::extent_v<A,D>...};
+}(std::make_index_sequence<std::rank_v<A>>{});
+
+// same_extents<A,B> arrays A and B have the same rank and extents
+template <typename A, typename B>
+constexpr bool same_extents()
+{
+    if constexpr (std::rank_v<A> != std::rank_v<B>)
+        return false;
+    else
+        return extents<A> == extents<B>;
+}
+
+// unravel<A>(i) converts flat index i to multi-index of A;
+// the outermost index is not reduced, so array_size<A> converts to
+// the one-past-the-end multi-index {extent,0,...,0}.
+template <typename A>
+constexpr auto unravel(size_t i) noexcept
+{
+    std::array<size_t, std::rank_v<A>> ix{};
+    for (size_t d = 0; d != std::rank_v<A>; ++d)
+    {
+        ix[d] = i / strides<A>[d];
+        i %= strides<A>[d];
+    }
+    return ix;
+}
+
+// element(p,i) returns the element at flat index i of array pointed to
+// by p; flat pointer access at runtime, hierarchical in constant evaluation
+template <typename T>
+constexpr auto& element(T* p, size_t i) noexcept
+{
+    if constexpr (!std::is_array_v<T>)
+        return p[i];
+    else
+    {
+        if (!std::is_constant_evaluated())
+            return flat(p)[i];
+        return element(p[i / array_size<T>], i % array_size<T>);
+    }
+}
+
+// flat_offset<A>(i...) row-major flat offset of multi-index i... into A,
+// (a prefix index i... is the offset of that subarray's first element)
+// as one multiply-add chain over compile-time constant strides
+template <typename A, typename... I>
+constexpr size_t flat_offset(I... i) noexcept
+{
+    return [=]<size_t... D>(std::index_sequence<D...>) {
+        return (... + (size_t(i)
+                       * std::integral_constant<size_t, strides<A>[D]>{}));
+    }(std::index_sequence_for<I...>{});
+}
+
+// subscript(p,i...) builtin chained subscript p[i0][i1]...
+template <typename T, typename I, typename... J>
+constexpr auto& subscript(T* p, I i, J... j) noexcept
+{
+    if constexpr (sizeof...(J) == 0)
+        return p[i];
+    else
+        return subscript(p[i], j...);
+}
+
+// synth_three_way(x,y) is x <=> y if available, else synthesized from <
+// (as for std::array comparison)
+struct synth_three_way
+{
+    template <typename T>
+    constexpr auto operator()(T const& x, T const& y) const
+    {
+        if constexpr (std::three_way_comparable<T>)
+            return x <=> y;
+        else
+            return x < y ? std::weak_ordering::less
+                 : y < x ? std::weak_ordering::greater
+                         : std::weak_ordering::equivalent;
+    }
+};
+template <typename T>
+using synth_three_way_result = decltype(synth_three_way{}(
+                                std::declval<T const&>(),
+                                std::declval<T const&>()));
+
+// is_bitwise_comparable<T> true if scalar T values compare equal exactly
+// when their object representations are equal (not floating point).
+template <typename T>
+inline constexpr bool is_bitwise_comparable = std::is_scalar_v<T>
+                    && std::has_unique_object_representations_v<T>;
+
+// flat_equal(x,y,n) true if n elements at x and y compare equal
+template <typename T, typename U>
+constexpr bool flat_equal(T const* x, U const* y, size_t n)
+{
+    if constexpr (is_bitwise_comparable<std::remove_cv_t<T>>)
+    {
+        if (!std::is_constant_evaluated())
+            return n == 0 || std::memcmp(x, y, n*sizeof(T)) == 0;
+    }
+    return std::equal(x, x+n, y);
+}
+
+// unrolled_equal(x,y,seq) all elements of small arrays x, y are equal,
+// compared without branches, e.g. for float[4][4]
+inline constexpr size_t unrolled_equal_max = 64;
+template <typename T, typename U, size_t... I>
+constexpr bool unrolled_equal(T* x, U* y, std::index_sequence<I...>)
+{
+    return (... & (element(x,I) == element(y,I)));
+}
+
+// fill_bytes(e) true if the object representation of e is a single
+// repeated byte value, e.g. all-zero, so a fill can be done by memset.
+template <typename T>
+requires std::is_trivially_copyable_v<T>
+bool fill_bytes(T const& e, unsigned char& byte) noexcept
+{
+    unsigned char rep[sizeof(T)];
+    std::memcpy(rep, &e, sizeof(T));
+    byte = rep[0];
+    return std::all_of(rep, rep+sizeof(T),
+                       [b=rep[0]](unsigned char c){ return c == b; });
+}
+}
+
+namespace array_nd
+{
+// is_expr_v<E> true for lazy element-wise expression types,
+// specialized by "array_nd_expr.hpp"
+template <typename E>
+inline constexpr bool is_expr_v = false;
+}
+
+// array_nd_elements<A>
+// Flat range of all elements of an A array, in row-major order.
+// Its iterator models std::contiguous_iterator over element_type.
+template <typename A>
+requires std::is_array_v<A> && std::extent_v<A> != 0
+struct array_nd_elements
+{
+    using element_type    = std::remove_all_extents_t<A>;
+    using value_type      = std::remove_cv_t<element_type>;
+    using difference_type = ptrdiff_t;
+    using size_type       = size_t;
+    using pointer         = element_type*;
+    using reference       = element_type&;
+
+    struct iterator
+    {
+        using iterator_concept  = std::contiguous_iterator_tag;
+        using iterator_category = std::random_access_iterator_tag;
+        using element_type      = array_nd_elements::element_type;
+        using value_type        = array_nd_elements::value_type;
+        using difference_type   = ptrdiff_t;
+        using pointer           = element_type*;
+        using reference         = element_type&;
+
+        std::remove_extent_t<A>* a = nullptr;
+        difference_type i = 0;
+
+        constexpr reference operator*() const { return impl::element(a,i); }
+        constexpr pointer operator->() const
+        {
+            if (!std::is_constant_evaluated())
+                return impl::flat(a) + i; // valid for end() too
+            return &impl::element(a,i);
+        }
+        constexpr reference operator[](difference_type n) const {
+            return impl::element(a,i+n);
+        }
+
+        constexpr iterator& operator++() { ++i; return *this; }
+        constexpr iterator& operator--() { --i; return *this; }
+        constexpr iterator operator++(int) { auto t = *this; ++i; return t; }
+        constexpr iterator operator--(int) { auto t = *this; --i; return t; }
+        constexpr iterator& operator+=(difference_type n) { i+=n; return *this; }
+        constexpr iterator& operator-=(difference_type n) { i-=n; return *this; }
+
+        friend constexpr iterator operator+(iterator x, difference_type n) {
+            return x += n;
+        }
+        friend constexpr iterator operator+(difference_type n, iterator x) {
+            return x += n;
+        }
+        friend constexpr iterator operator-(iterator x, difference_type n) {
+            return x -= n;
+        }
+        friend constexpr difference_type operator-(iterator x, iterator y) {
+            return x.i - y.i;
+        }
+        friend constexpr bool operator==(iterator x, iterator y) {
+            return x.i == y.i;
+        }
+        friend constexpr auto operator<=>(iterator x, iterator y) {
+            return x.i <=> y.i;
+        }
+    };
+    using const_iterator = iterator;
+
+    std::remove_extent_t<A>* a;
+
+    constexpr iterator begin() const noexcept { return {a, 0}; }
+    constexpr iterator end() const noexcept { return {a, array_size<A>}; }
+    static constexpr size_t size() noexcept { return array_size<A>; }
+    static constexpr bool empty() noexcept { return false; }
+
+    constexpr reference operator[](size_t i) const {
+        return impl::element(a,i);
+    }
+    // data() is a valid constant expression but, as for impl::flat,
+    // arithmetic on it is not; use indexing or iterators in constexpr.
+    constexpr pointer data() const noexcept { return impl::flat(a); }
+};
+
 template <typename A>
 requires std::is_array_v<A> && std::extent_v<A> != 0
 struct array_nd_ref
@@ -138,6 +404,39 @@ struct array_nd_ref
     constexpr decltype(auto) operator()(size_t I);
     constexpr decltype(auto) operator()(size_t I) const;
 
+    // (i,j,k...) multi-index; a full index returns the element, computed
+    // as one flat offset at runtime; a partial index returns array_nd_ref
+    // wrapped subarray
+    template <typename... I>
+    requires (sizeof...(I) >= 2) && (sizeof...(I) <= rank)
+          && (std::is_convertible_v<I,size_t> && ...)
+    constexpr decltype(auto) operator()(I... i) const
+    {
+        if constexpr (sizeof...(I) == rank)
+        {
+            if (!std::is_constant_evaluated())
+                return impl::flat(a)[impl::flat_offset<A>(i...)];
+            return impl::subscript(a, i...);
+        }
+        else
+            return ::array_nd_ref{impl::subscript(a, i...)};
+    }
+
+#if defined(__cpp_multidimensional_subscript)
+    // [i,j,k...] multi-index, as (i,j,k...) but a partial index
+    // returns builtin C subarray&, as does [index]
+    template <typename... I>
+    requires (sizeof...(I) >= 2) && (sizeof...(I) <= rank)
+          && (std::is_convertible_v<I,size_t> && ...)
+    constexpr decltype(auto) operator[](I... i) const
+    {
+        if constexpr (sizeof...(I) == rank)
+            return operator()(i...);
+        else
+            return impl::subscript(a, i...);
+    }
+#endif
+
     constexpr reference at(size_t I);
     constexpr const_reference at(size_t I) const;
 
@@ -161,6 +460,12 @@ struct array_nd_ref
     constexpr const_reverse_iterator crbegin() const noexcept { return rbegin(); }
     constexpr const_reverse_iterator crend() const noexcept { return rend(); }
 
+    // elements() flat row-major range of all elements, see above
+    constexpr array_nd_elements<A> elements() noexcept { return {a}; }
+    constexpr array_nd_elements<A const> elements() const noexcept {
+        return {a};
+    }
+
     // Non-const data() member function returns a ref to the full array type
     A& data() noexcept { return *reinterpret_cast<A*>(a); } // try bit_cast?
     // The const data() member function returns the array decay; a pointer
@@ -174,23 +479,33 @@ struct array_nd_ref
     constexpr bool operator!=( A const& y) const {
            return !operator==(y);
     }
+    constexpr auto operator<=>( A const& y) const {
+              return *this <=> array_nd_ref<A const>{y};
+    }
     constexpr bool operator<( A const& y) const {
-              return *this < array_nd_ref<A const>{y};
+              return (*this <=> y) < 0;
     }
     constexpr bool operator>( A const& y) const {
-              return *this > array_nd_ref<A const>{y};
+              return (*this <=> y) > 0;
     }
     constexpr bool operator<=( A const& y) const {
-              return *this <= array_nd_ref<A const>{y};
+              return (*this <=> y) <= 0;
     }
     constexpr bool operator>=( A const& y) const {
-              return *this >= array_nd_ref<A const>{y};
+              return (*this <=> y) >= 0;
     }
 
     // mutators, but only via ref, not const qualified
     constexpr void fill( const value_type& e);
     // deep copy of C-array rhs to referred-to array
     constexpr type operator=( array_type const& rhs);
+    // deep assign from a lazy element-wise expression, see array_nd_expr
+    template <typename E>
+    requires array_nd::is_expr_v<E>
+    constexpr type operator=( E const& e) {
+        expr_assign(*this, e);
+        return *this;
+    }
     //constexpr type operator=( type& rhs) { return *this = rhs.a; }
     //constexpr type operator=( const_type& rhs) { return *this = rhs.a; };
     constexpr void swap( A& b) noexcept(std::is_nothrow_swappable_v<value_type>)
@@ -262,10 +577,24 @@ constexpr auto array_nd_ref<A>::at(size_t I) const -> const_reference
 
 
 // fill,and op= have similar recursive implementations
+// At runtime, trivially copyable elements are filled or copied flat,
+// as one block operation over sizeof(A) bytes (memset or memmove).
 template <typename A>
 requires std::is_array_v<A> && std::extent_v<A> != 0
 constexpr void array_nd_ref<A>::fill( value_type const& e)
 {
+    if constexpr (std::is_trivially_copyable_v<value_type>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            unsigned char byte;
+            if (impl::fill_bytes(e, byte))
+                std::memset(impl::flat(a), byte, sizeof(A));
+            else
+                std::fill_n(impl::flat(a), array_size<A>, e);
+            return;
+        }
+    }
     if constexpr (rank == 1)
         std::fill_n(a, extent, e);
     else
@@ -278,6 +607,15 @@ requires std::is_array_v<A> && std::extent_v<A> != 0
 constexpr auto array_nd_ref<A>::operator=( array_type const& rhs)
             -> array_nd_ref<A>
 {
+    if constexpr (std::is_trivially_copyable_v<value_type>)
+    {
+        // memmove, not memcpy; self-assign and overlapping windows are ok
+        if (!std::is_constant_evaluated())
+        {
+            std::memmove(impl::flat(a), impl::flat(rhs), sizeof(A));
+            return *this;
+        }
+    }
     if constexpr (rank == 1)
         std::copy(rhs, rhs+extent, a);
     else
@@ -318,27 +656,81 @@ requires std::is_array_v<A> && std::extent_v<A> != 0
 constexpr size_t size( array_nd_ref<A> a) { return a.size(); }
 
 
+namespace impl
+{
+// mismatch_index(x,y) returns the flat index of the first element where
+// x != y, or array_size<A> if all are equal.
+// At runtime the arrays are compared flat, in blocks:
+//   bitwise comparable elements by memcmp (vectorized by the C library),
+//   other arithmetic elements by a branch-free block compare loop.
+// Constant evaluation recurses hierarchically.
+template <typename A, typename Ac>
+constexpr size_t mismatch_index( array_nd_ref<A> x, array_nd_ref<Ac> y)
+{
+    using T = typename array_nd_ref<A>::value_type;
+    constexpr size_t N = array_size<A>;
+    if (!std::is_constant_evaluated())
+    {
+        auto xf = flat(x.a);
+        auto yf = flat(y.a);
+        size_t i = 0;
+        if constexpr (is_bitwise_comparable<T>)
+        {
+            constexpr size_t B = sizeof(T) < 512 ? 512/sizeof(T) : 1;
+            for (; i + B <= N; i += B)
+                if (std::memcmp(xf+i, yf+i, B*sizeof(T)) != 0)
+                    break;
+        }
+        else if constexpr (std::is_arithmetic_v<T>)
+        {
+            constexpr size_t B = 64;
+            for (; i + B <= N; i += B)
+            {
+                bool ne = false;
+                for (size_t j = 0; j != B; ++j)
+                    ne |= xf[i+j] != yf[i+j];
+                if (ne)
+                    break;
+            }
+        }
+        return std::mismatch(xf+i, xf+N, yf+i).first - xf;
+    }
+    if constexpr (std::rank_v<A> == 1)
+    {
+        for (size_t i=0; i != N; ++i)
+            if (x[i] != y[i])
+                return i;
+        return N;
+    }
+    else
+    {
+        constexpr size_t S = strides<A>[0];
+        for (size_t i=0; i != std::extent_v<A>; ++i)
+            if (size_t m = mismatch_index(x(i), y(i)); m != S)
+                return i*S + m;
+        return N;
+    }
+}
+}
+
 template <typename A, typename Ac>
 requires std::is_array_v<A> && std::extent_v<A> != 0
       && std::is_same_v<std::remove_const_t<A>, std::remove_const_t<Ac>>
 constexpr bool
 operator==( array_nd_ref<A> x, array_nd_ref<Ac> y)
 {
-    if constexpr (std::rank<A>::value == 1)
-        //return std::equal(x.begin(), x.end(), y.begin());
-        return [x,y]()->bool
-        {
-            for (size_t i=0; i != x.size(); ++i)
-                if (x(i) != y(i)) return false;
-            return true;
-        }();
-    else
+    using T = typename array_nd_ref<A>::value_type;
+    if constexpr (impl::is_bitwise_comparable<T>)
     {
-        for (unsigned i=0; i < std::extent_v<A>; ++i)
-            if (!(x(i) == y(i)))
-                return false;
-        return true;
-    }   
+        if (!std::is_constant_evaluated())
+            return std::memcmp(impl::flat(x.a), impl::flat(y.a),
+                               sizeof(A)) == 0;
+    }
+    else if constexpr (std::is_arithmetic_v<T>
+                    && array_size<A> <= impl::unrolled_equal_max)
+        return impl::unrolled_equal(x.a, y.a,
+                                std::make_index_sequence<array_size<A>>{});
+    return impl::mismatch_index(x, y) == array_size<A>;
 }
 
 template <typename A, typename Ac>
@@ -350,24 +742,29 @@ operator!=( array_nd_ref<A> x, array_nd_ref<Ac> y)
     return !(x == y);
 }
 
+// Three-way comparison is lexicographic as-if flat arrays, in one pass:
+// the ordering of the first mismatched elements, if any, else equal.
+template <typename A, typename Ac>
+requires std::is_array_v<A> && std::extent_v<A> != 0
+      && std::is_same_v<std::remove_const_t<A>, std::remove_const_t<Ac>>
+constexpr auto
+operator<=>( array_nd_ref<A> x, array_nd_ref<Ac> y)
+   -> impl::synth_three_way_result<typename array_nd_ref<A>::value_type>
+{
+    size_t i = impl::mismatch_index(x, y);
+    if (i == array_size<A>)
+        return std::strong_ordering::equal;
+    return impl::synth_three_way{}(impl::element(x.a, i),
+                                   impl::element(y.a, i));
+}
+
 template <typename A, typename Ac>
 requires std::is_array_v<A> && std::extent_v<A> != 0
       && std::is_same_v<std::remove_const_t<A>, std::remove_const_t<Ac>>
 constexpr bool
 operator<( array_nd_ref<A> x, array_nd_ref<Ac> y)
 {
-    if constexpr (std::rank<A>::value == 1)
-        return std::lexicographical_compare(x.begin(), x.end(),
-                                            y.begin(), y.end());
-    else
-    {
-        for (unsigned i=0; i < std::extent_v<A>; ++i)
-            if ((x(i) < y(i)))
-                return true;
-            else if ((x(i) > y(i)))
-                return false;
-        return false;
-    }   
+    return (x <=> y) < 0;
 }
 
 template <typename A, typename Ac>
@@ -376,7 +773,7 @@ requires std::is_array_v<A> && std::extent_v<A> != 0
 constexpr bool
 operator>( array_nd_ref<A> x, array_nd_ref<Ac> y)
 {
-    return y < x;
+    return (x <=> y) > 0;
 }
 
 template <typename A, typename Ac>
@@ -385,7 +782,7 @@ requires std::is_array_v<A> && std::extent_v<A> != 0
 constexpr bool
 operator<=( array_nd_ref<A> x, array_nd_ref<Ac> y)
 {
-    return !(y < x);
+    return (x <=> y) <= 0;
 }
 
 template <typename A, typename Ac>
@@ -394,10 +791,60 @@ requires std::is_array_v<A> && std::extent_v<A> != 0
 constexpr bool
 operator>=( array_nd_ref<A> x, array_nd_ref<Ac> y)
 {
-    return !(x < y);
+    return (x <=> y) >= 0;
 }
 
 
+namespace array_nd
+{
+// mismatch_result<A> position of the first differing element, if any,
+// as flat row-major index and as multi-index.
+// No mismatch gives the one-past-the-end position:
+//   index == array_size<A>, indices == {extent,0,...,0}
+template <typename A>
+struct mismatch_result
+{
+    size_t index;
+    std::array<size_t, std::rank_v<A>> indices;
+
+    constexpr explicit operator bool() const noexcept
+    {
+        return index != array_size<A>;
+    }
+};
+}
+
+template <typename A, typename Ac>
+requires std::is_array_v<A> && std::extent_v<A> != 0
+      && std::is_same_v<std::remove_const_t<A>, std::remove_const_t<Ac>>
+constexpr array_nd::mismatch_result<std::remove_cv_t<A>>
+mismatch( array_nd_ref<A> x, array_nd_ref<Ac> y)
+{
+    size_t i = impl::mismatch_index(x, y);
+    return {i, impl::unravel<A>(i)};
+}
+
+// reshape<B>(x) views the elements of x as an array B of the same size
+// and element type, e.g. T[64][64] as T[4096] or T[16][4][64], no copy;
+// the cv-qualification of x carries over to the view.
+// A constant expression only for B the same shape as x, as the view
+// otherwise reinterprets the array type (as does non-const data()).
+template <typename B, typename A>
+requires std::is_array_v<B> && std::extent_v<B> != 0
+      && (array_size<B> == array_size<A>)
+      && std::is_same_v<std::remove_cv_t<std::remove_all_extents_t<B>>,
+                        std::remove_cv_t<std::remove_all_extents_t<A>>>
+constexpr auto
+reshape( array_nd_ref<A> x) noexcept
+{
+    using R = copy_cv<std::remove_all_extents_t<A>, B>;
+    using P = std::remove_extent_t<R>*;
+    if constexpr (std::is_same_v<std::remove_cv_t<R>, std::remove_cv_t<A>>)
+        return array_nd_ref<R>{x.a};
+    else
+        return array_nd_ref<R>{reinterpret_cast<P>(impl::flat(x.a))};
+}
+
 template <size_t I, typename A>
 requires I < std::extent_v<A>
 constexpr auto&
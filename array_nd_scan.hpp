@@ -0,0 +1,350 @@
+//    Copyright (c) 2018 Will Wray https://keybase.io/willwray
+//
+//   Distributed under the Boost Software License, Version 1.0.
+//          (http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include "array_nd_execution.hpp"
+#include "array_nd_reduce.hpp"
+
+/*
+   "array_nd_scan.hpp"
+    ^^^^^^^^^^^^^^^^^
+    Prefix scans along one axis of a C-array or array_nd_ref, and
+    2D summed-area tables, optionally under an execution policy.
+
+  Usage:
+      uint32_t img[480][640], sat[480][640];
+      array_nd::summed_area_table(img, array_nd_ref{sat});
+      // box sum of rows [i0,i1), columns [j0,j1) is then
+      //   sat[i1-1][j1-1] - sat[i0-1][j1-1] - sat[i1-1][j0-1] + sat[i0-1][j0-1]
+      array_nd::inclusive_scan_axis<1>(std::execution::par,
+                                       img, array_nd_ref{sat});
+
+  Functions, in namespace array_nd, each with an overload taking
+  an execution policy as first argument:
+    inclusive_scan_axis<K>(x, dst, op = +)
+        dst[..n..] = x[..0..] op ... op x[..n..], along axis K
+    exclusive_scan_axis<K>(x, dst, init = 0, op = +)
+        dst[..n..] = init op x[..0..] op ... op x[..n-1..]
+    summed_area_table(x, dst)
+        dst[i][j] = sum of x[0..i][0..j], for rank 2 x
+
+  dst is of the shape of x and of any element type, the accumulator
+  type, checked at compile time. dst may be x itself, for in-place scan.
+  All are constexpr, for compile-time tables.
+
+  As for reduce_axis, x is viewed as [O][N][I], N the extent of axis K,
+  and read in memory order: runs of I contiguous elements are combined
+  element-wise with the previous run's results. Along the innermost axis,
+  I == 1, each contiguous row is scanned; for integer addition into the
+  same type the row scan is SIMD, by log2 shifted adds within a register
+  and a broadcast carry between registers.
+  Under a parallel policy the tasks are outer subarrays, or for axis 0
+  column blocks; a summed-area table is then a scan of rows followed by
+  a scan of columns.
+*/
+namespace impl
+{
+// serial_policy runs scan tasks in the calling thread, as one task
+struct serial_policy {};
+
+// scan_simd<T,Acc,Op> the in-register row scan applies
+template <typename T, typename Acc, typename Op>
+inline constexpr bool scan_simd = std::is_same_v<T,Acc>
+                               && std::is_integral_v<T>
+                               && !std::is_same_v<T,bool>
+                               && std::is_same_v<Op,std::plus<>>;
+
+// lane_shift<S>(x) lanes of simd x moved up by S, zeros shifted in;
+// lane_last(x) the last lane of x broadcast to all lanes
+template <size_t S, typename T>
+simd_t<T> lane_shift(simd_t<T> x)
+{
+    using M = simd_t<std::make_signed_t<T>>;
+    constexpr size_t W = sizeof x / sizeof(T);
+    constexpr M m = []<size_t... l>(std::index_sequence<l...>) {
+        return M{ (l >= S ? l - S : W + l)... };
+    }(std::make_index_sequence<W>{});
+    return __builtin_shuffle(x, simd_t<T>{}, m);
+}
+template <typename T>
+simd_t<T> lane_last(simd_t<T> x)
+{
+    using M = simd_t<std::make_signed_t<T>>;
+    constexpr M m = M{} + std::make_signed_t<T>(sizeof x / sizeof(T) - 1);
+    return __builtin_shuffle(x, m);
+}
+
+// scan_row<Ex>(s,d,n,acc) + scan of n contiguous integers s into d,
+// starting from acc, inclusive or exclusive
+template <bool Ex, typename T>
+void scan_row(T const* s, T* d, size_t n, T acc)
+{
+    using V = simd_t<T>;
+    constexpr size_t W = sizeof(V) / sizeof(T);
+    size_t i = 0;
+    if (n >= W)
+    {
+        V c = V{} + acc;
+        for (; i != n - n % W; i += W)
+        {
+            V x;
+            std::memcpy(&x, s + i, sizeof x);
+            [&]<size_t... k>(std::index_sequence<k...>) {
+                ((x += lane_shift<size_t{1} << k, T>(x)), ...);
+            }(std::make_index_sequence<std::bit_width(W) - 1>{});
+            V const y = (Ex ? lane_shift<1,T>(x) : x) + c;
+            c += lane_last<T>(x);
+            std::memcpy(d + i, &y, sizeof y);
+        }
+        acc = c[0];
+    }
+    for (; i < n; ++i)
+    {
+        T const v = s[i];
+        if constexpr (Ex)
+            d[i] = acc;
+        acc += v;
+        if constexpr (!Ex)
+            d[i] = acc;
+    }
+}
+
+// scan_block<Ex>(s,d,N,I,i0,i1,init,op) scans s viewed as [N][I] along N
+// into d, for columns [i0,i1)
+template <bool Ex, typename T, typename Acc, typename Op>
+void scan_block(T const* s, Acc* d, size_t N, size_t I,
+                size_t i0, size_t i1, Acc init, Op op)
+{
+    if (I == 1)
+    {
+        if constexpr (scan_simd<T,Acc,Op>)
+            scan_row<Ex>(s, d, N, Ex ? init : T{});
+        else if constexpr (Ex)
+            for (size_t n = 0; n != N; ++n)
+            {
+                Acc const v = s[n];
+                d[n] = init;
+                init = op(init, v);
+            }
+        else
+        {
+            d[0] = static_cast<Acc>(s[0]);
+            for (size_t n = 1; n != N; ++n)
+                d[n] = op(d[n-1], s[n]);
+        }
+        return;
+    }
+    if constexpr (!Ex)
+    {
+        for (size_t i = i0; i != i1; ++i)
+            d[i] = static_cast<Acc>(s[i]);
+        for (size_t n = 1; n != N; ++n)
+        {
+            T const* r = s + n*I;
+            Acc* w = d + n*I;
+            Acc const* u = w - I;
+#pragma GCC ivdep
+            for (size_t i = i0; i != i1; ++i)
+                w[i] = op(u[i], r[i]);
+        }
+    }
+    else
+    {
+        // carried sums, a block at a time, allow in-place s == d
+        constexpr size_t C = axis_block_bytes / sizeof(Acc);
+        Acc carry[C];
+        for (size_t j0 = i0; j0 < i1; j0 += C)
+        {
+            size_t const c = std::min(C, i1 - j0);
+            std::fill_n(carry, c, init);
+            for (size_t n = 0; n != N; ++n)
+            {
+                T const* r = s + n*I + j0;
+                Acc* w = d + n*I + j0;
+#pragma GCC ivdep
+                for (size_t i = 0; i != c; ++i)
+                {
+                    Acc const v = r[i];
+                    w[i] = carry[i];
+                    carry[i] = op(carry[i], v);
+                }
+            }
+        }
+    }
+}
+
+// scan_tasks<A,K>(policy,f) calls f(o0,o1,i0,i1) on [O][N][I] views of A
+// for ranges of outer subarrays, or for K == 0 of columns, as tasks
+template <typename A, size_t K, typename Policy, typename F>
+void scan_tasks(Policy&& policy, F f)
+{
+    constexpr size_t N = std::extent_v<A,K>, I = strides<A>[K];
+    constexpr size_t O = array_size<A> / (N*I);
+    // column blocks are whole cache lines
+    constexpr size_t L = std::max(size_t{64} / sizeof(remove_all_extents_t<A>),
+                                  size_t{1});
+    constexpr size_t P = O != 1 ? O : (I + L-1) / L;
+    constexpr size_t tasks = std::clamp(sizeof(A) / array_nd::min_chunk_bytes,
+                                        size_t{1}, P);
+    if constexpr (tasks == 1
+               || std::is_same_v<std::remove_cvref_t<Policy>,serial_policy>)
+        f(size_t{0}, O, size_t{0}, I);
+    else
+    {
+        std::vector<size_t> ix(tasks);
+        std::iota(ix.begin(), ix.end(), size_t{0});
+        std::for_each(std::forward<Policy>(policy), ix.begin(), ix.end(),
+            [&f](size_t t) {
+                size_t const b = t * P / tasks, e = (t + 1) * P / tasks;
+                if constexpr (O != 1)
+                    f(b, e, size_t{0}, I);
+                else
+                    f(size_t{0}, size_t{1}, b * L, std::min(e * L, size_t{I}));
+            });
+    }
+}
+
+// scan_axis<K,Ex>(policy,x,dst,init,op) the runtime scan
+template <size_t K, bool Ex, typename Policy,
+          typename A, typename D, typename Acc, typename Op>
+void scan_axis(Policy&& policy, array_nd_ref<A> x, array_nd_ref<D> dst,
+               Acc init, Op op)
+{
+    constexpr size_t N = std::extent_v<A,K>, I = strides<A>[K];
+    auto s = flat(x.a);
+    auto d = flat(dst.a);
+    scan_tasks<std::remove_cv_t<A>,K>(std::forward<Policy>(policy),
+        [=](size_t o0, size_t o1, size_t i0, size_t i1) {
+            for (size_t o = o0; o != o1; ++o)
+                scan_block<Ex>(s + o*N*I, d + o*N*I, N, I, i0, i1, init, op);
+        });
+}
+
+// scan_fold<K,Ex>(x,dst,init,op) the constant-evaluable scan
+template <size_t K, bool Ex, typename A, typename D, typename Acc, typename Op>
+constexpr void scan_fold(array_nd_ref<A> x, array_nd_ref<D> dst,
+                         Acc init, Op op)
+{
+    constexpr size_t N = std::extent_v<A,K>, I = strides<A>[K];
+    constexpr size_t O = array_size<A> / (N*I);
+    for (size_t o = 0; o != O; ++o)
+        for (size_t i = 0; i != I; ++i)
+        {
+            Acc a = init;
+            for (size_t n = 0; n != N; ++n)
+            {
+                size_t const f = (o*N + n)*I + i;
+                Acc const v = element(x.a, f);
+                a = Ex ? a : n ? op(a, v) : v;
+                element(dst.a, f) = a;
+                if constexpr (Ex)
+                    a = op(a, v);
+            }
+        }
+}
+
+// scan_dst<A,K,D> dst array D is of the shape of A, which has an axis K
+template <typename A, size_t K, typename D>
+concept bool scan_dst = (K < std::rank_v<A>) && same_extents<A,D>();
+}
+
+namespace array_nd
+{
+template <size_t K, typename X, typename D, typename Op = std::plus<>>
+requires impl::array_or_ref<X> && impl::scan_dst<impl::ref_array_t<X>,K,D>
+constexpr void inclusive_scan_axis(X const& x, array_nd_ref<D> dst,
+                                   Op op = {})
+{
+    using Acc = std::remove_all_extents_t<D>;
+    if (std::is_constant_evaluated())
+        impl::scan_fold<K,false>(impl::as_ref(x), dst, Acc{}, op);
+    else
+        impl::scan_axis<K,false>(impl::serial_policy{},
+                                 impl::as_ref(x), dst, Acc{}, op);
+}
+
+template <size_t K, typename X, typename D, typename Op = std::plus<>>
+requires impl::array_or_ref<X> && impl::scan_dst<impl::ref_array_t<X>,K,D>
+constexpr void exclusive_scan_axis(X const& x, array_nd_ref<D> dst,
+                                   std::remove_all_extents_t<D> init = {},
+                                   Op op = {})
+{
+    if (std::is_constant_evaluated())
+        impl::scan_fold<K,true>(impl::as_ref(x), dst, init, op);
+    else
+        impl::scan_axis<K,true>(impl::serial_policy{},
+                                impl::as_ref(x), dst, init, op);
+}
+
+template <typename X, typename D>
+requires impl::array_or_ref<X> && impl::scan_dst<impl::ref_array_t<X>,1,D>
+      && (std::rank_v<D> == 2)
+constexpr void summed_area_table(X const& x, array_nd_ref<D> dst)
+{
+    using Acc = std::remove_all_extents_t<D>;
+    auto r = impl::as_ref(x);
+    if (std::is_constant_evaluated())
+    {
+        impl::scan_fold<1,false>(r, dst, Acc{}, std::plus<>{});
+        impl::scan_fold<0,false>(dst, dst, Acc{}, std::plus<>{});
+        return;
+    }
+    // one pass: scan each row, then add in the previous, cached, dst row
+    constexpr size_t H = std::extent_v<D,0>, W = std::extent_v<D,1>;
+    auto s = impl::flat(r.a);
+    auto d = impl::flat(dst.a);
+    for (size_t i = 0; i != H; ++i, s += W, d += W)
+    {
+        impl::scan_block<false>(s, d, W, 1, 0, 1, Acc{}, std::plus<>{});
+        if (i != 0)
+        {
+            Acc const* u = d - W;
+#pragma GCC ivdep
+            for (size_t j = 0; j != W; ++j)
+                d[j] += u[j];
+        }
+    }
+}
+
+template <size_t K, typename Policy, typename X, typename D,
+          typename Op = std::plus<>>
+requires impl::execution_policy<Policy>
+      && impl::array_or_ref<X> && impl::scan_dst<impl::ref_array_t<X>,K,D>
+void inclusive_scan_axis(Policy&& policy, X const& x, array_nd_ref<D> dst,
+                         Op op = {})
+{
+    impl::scan_axis<K,false>(std::forward<Policy>(policy), impl::as_ref(x),
+                             dst, std::remove_all_extents_t<D>{}, op);
+}
+
+template <size_t K, typename Policy, typename X, typename D,
+          typename Op = std::plus<>>
+requires impl::execution_policy<Policy>
+      && impl::array_or_ref<X> && impl::scan_dst<impl::ref_array_t<X>,K,D>
+void exclusive_scan_axis(Policy&& policy, X const& x, array_nd_ref<D> dst,
+                         std::remove_all_extents_t<D> init = {}, Op op = {})
+{
+    impl::scan_axis<K,true>(std::forward<Policy>(policy), impl::as_ref(x),
+                            dst, init, op);
+}
+
+template <typename Policy, typename X, typename D>
+requires impl::execution_policy<Policy>
+      && impl::array_or_ref<X> && impl::scan_dst<impl::ref_array_t<X>,1,D>
+      && (std::rank_v<D> == 2)
+void summed_area_table(Policy&& policy, X const& x, array_nd_ref<D> dst)
+{
+    inclusive_scan_axis<1>(policy, x, dst);
+    inclusive_scan_axis<0>(policy, dst, dst);
+}
+}
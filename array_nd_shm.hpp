@@ -0,0 +1,209 @@
+//    Copyright (c) 2018 Will Wray https://keybase.io/willwray
+//
+//   Distributed under the Boost Software License, Version 1.0.
+//          (http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "array_nd_mmap.hpp"
+
+/*
+   "array_nd_shm.hpp"
+    ^^^^^^^^^^^^^^^^
+    array_nd::shm_array, a C-array in POSIX shared memory, one copy
+    shared by the processes of a host.
+
+  Usage:
+      using table = float[1024][4096];
+      // one process builds and publishes the table
+      auto t = array_nd::shm_array<table>::create("/lut", version);
+      fill(t.ref());
+      t.publish();
+      // others map it, read-only, once published
+      auto r = array_nd::shm_array<table const>::open("/lut", version,
+                                                      std::chrono::seconds{5});
+      array_nd_ref<table const> lut = r;
+
+  shm_array<A>
+    Owns one shared mapping of a shm_open object that holds a header
+    and an A, and unmaps it on destruction; move-only. The mapping is
+    read-only for const A, else read-write. The element type must be
+    trivially copyable. The object persists until unlink(name).
+
+  Functions:
+    create(name, version = 0)   creates the object, which must not exist,
+                                zero-filled and not ready; for non-const A.
+                                On failure the name is removed again
+    open(name, version = 0, timeout = 0)
+                                maps the object once it exists and is ready,
+                                polling up to timeout; throws if it is not
+                                ready by then or does not hold an A of the
+                                same version
+    publish()                   marks the contents ready, to open
+    ready()                     whether published
+    unlink(name)                removes the name; mappings remain valid
+    ref(), data()               the array_nd_ref view, the A& array
+
+  Header:
+    The array_file_header, as of "array_nd_mmap.hpp", records element
+    type and extents; a user version number follows, then a ready flag.
+    create constructs the header in the new object. The flag is a plain
+    uint32_t, accessed only through std::atomic_ref: stored with release
+    order by publish and loaded with acquire order by open, so that a
+    reader that sees the flag also sees the contents. The A follows at
+    offset 320, 64-byte aligned.
+
+  Errors in system calls throw std::system_error, with the errno;
+  an object that does not hold a ready A throws std::runtime_error.
+*/
+namespace impl
+{
+// shm_header precedes the array in a shared memory object
+struct shm_header
+{
+    array_file_header array;
+    uint64_t version;
+    alignas(std::atomic_ref<uint32_t>::required_alignment) uint32_t ready;
+};
+inline constexpr size_t shm_offset = 320;
+static_assert(sizeof(shm_header) <= shm_offset
+           && std::is_trivially_copyable_v<shm_header>
+           && std::atomic_ref<uint32_t>::is_always_lock_free);
+
+// shm_name(name) the name with the leading '/' that POSIX asks for
+inline std::string shm_name(std::string const& name)
+{
+    return name.starts_with('/') ? name : '/' + name;
+}
+}
+
+namespace array_nd
+{
+template <typename A>
+requires std::is_array_v<A> && std::extent_v<A> != 0
+      && std::is_trivially_copyable_v<std::remove_all_extents_t<A>>
+class shm_array
+{
+  public:
+    using array_type = A;
+    using element_type = std::remove_all_extents_t<A>;
+    static constexpr bool writable = !std::is_const_v<A>;
+    static constexpr size_t bytes = impl::shm_offset + sizeof(A);
+
+    static shm_array create(std::string const& name, uint64_t version = 0)
+    requires writable
+    {
+        std::string const n = impl::shm_name(name);
+        impl::file_descriptor f{::shm_open(n.c_str(),
+                                           O_RDWR | O_CREAT | O_EXCL, 0666),
+                                "array_nd::shm_array shm_open"};
+        // a failure after shm_open leaves no name behind
+        try {
+            if (::ftruncate(f.fd, off_t(bytes)) != 0)
+                impl::throw_errno("array_nd::shm_array ftruncate");
+            shm_array s{f.fd};
+            ::new (s.base) impl::shm_header{impl::file_header<A>(),
+                                            version, 0};
+            return s;
+        } catch (...) { ::shm_unlink(n.c_str()); throw; }
+    }
+
+    static shm_array open(std::string const& name, uint64_t version = 0,
+                          std::chrono::milliseconds timeout = {})
+    {
+        std::string const n = impl::shm_name(name);
+        auto const until = std::chrono::steady_clock::now() + timeout;
+        auto pause = std::chrono::microseconds{10};
+        auto const wait = [&](char const* what) {
+            if (std::chrono::steady_clock::now() >= until)
+                throw std::runtime_error(what);
+            std::this_thread::sleep_for(pause);
+            pause = std::min(pause * 2, std::chrono::microseconds{10000});
+        };
+        // the creator may not yet have created, or sized, the object
+        int const flags = writable ? O_RDWR : O_RDONLY;
+        int fd;
+        while ((fd = ::shm_open(n.c_str(), flags, 0)) < 0
+            && errno == ENOENT && std::chrono::steady_clock::now() < until)
+            wait("array_nd::shm_array: not ready");
+        impl::file_descriptor f{fd, "array_nd::shm_array shm_open"};
+        for (struct stat st; ; wait("array_nd::shm_array: not ready"))
+        {
+            if (::fstat(f.fd, &st) != 0)
+                impl::throw_errno("array_nd::shm_array fstat");
+            if (size_t(st.st_size) == bytes)
+                break;
+            if (size_t(st.st_size) != 0)
+                throw std::runtime_error(
+                    "array_nd::shm_array: object size differs from the array");
+        }
+        shm_array s{f.fd};
+        while (!s.ready())
+            wait("array_nd::shm_array: not ready");
+        impl::check_file_header<A>(s.header().array);
+        if (s.header().version != version)
+            throw std::runtime_error("array_nd::shm_array: version differs");
+        return s;
+    }
+
+    static void unlink(std::string const& name)
+    {
+        if (::shm_unlink(impl::shm_name(name).c_str()) != 0)
+            impl::throw_errno("array_nd::shm_array shm_unlink");
+    }
+
+    shm_array(shm_array&& o) noexcept : base{std::exchange(o.base, nullptr)} {}
+    shm_array& operator=(shm_array&& o) noexcept
+    {
+        std::swap(base, o.base);
+        return *this;
+    }
+    ~shm_array() { if (base) ::munmap(base, bytes); }
+
+    void publish() const noexcept requires writable {
+        std::atomic_ref<uint32_t>{header().ready}
+            .store(1, std::memory_order_release);
+    }
+    bool ready() const noexcept {
+        return std::atomic_ref<uint32_t>{header().ready}
+                   .load(std::memory_order_acquire) != 0;
+    }
+
+    operator array_nd_ref<A>() const noexcept { return ref(); }
+    array_nd_ref<A> ref() const noexcept { return {data()}; }
+    A& data() const noexcept {
+        return *std::launder(reinterpret_cast<A*>(
+                                 static_cast<char*>(base) + impl::shm_offset));
+    }
+
+  private:
+    explicit shm_array(int fd)
+    {
+        int const prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+        base = ::mmap(nullptr, bytes, prot, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED)
+            impl::throw_errno("array_nd::shm_array mmap");
+    }
+    impl::shm_header& header() const noexcept {
+        return *std::launder(static_cast<impl::shm_header*>(base));
+    }
+
+    void* base;
+};
+}
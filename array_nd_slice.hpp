@@ -0,0 +1,333 @@
+//    Copyright (c) 2018 Will Wray https://keybase.io/willwray
+//
+//   Distributed under the Boost Software License, Version 1.0.
+//          (http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "array_nd_dyn_ref.hpp"
+
+/*
+   "array_nd_slice.hpp"
+    ^^^^^^^^^^^^^^^^^^
+    This header defines array_nd_slice, a strided view of rank R over
+    T elements, and slice(), a zero-copy submdspan-style slicing function
+    for array_nd_ref, array_nd_dyn_ref, C-arrays and slices.
+
+  Usage:
+      float big[64][64][8];
+      using array_nd::range, array_nd::all;
+      auto s = slice(array_nd_ref{big}, range{2,10}, all, 3);
+                  // rows 2..9, all columns, channel 3: a rank 2 view
+      s.fill(0);  // writes through to big
+
+  Slice specifiers, one per dimension from the outermost;
+  trailing unspecified dimensions are taken whole:
+    integer i             selects index i, removing the dimension
+    range{first,last}     half-open index range [first,last)
+    range{first,last,n}   every n'th index of [first,last)
+    all                   the whole dimension
+  Slice bounds are a precondition, not checked.
+
+  array_nd_slice<T,R>
+    Holds T* to the first element plus extents and element strides.
+    operator[], operator() index the outer dimension, as array_nd_ref;
+    operator()(i,j,...) with R indices gives the element.
+    fill, assign (deep copy from any view of equal extents, else throws
+    std::length_error), == compare.
+    Copy and assignment of slices is shallow; use assign() to copy data.
+
+  Fill, copy and compare walk the view as rows along the innermost
+  dimension. Rows of unit stride are processed by contiguous block
+  operations (fill_n, copy_n, memcmp) and a view that is contiguous
+  as a whole is processed as a single row.
+*/
+namespace array_nd
+{
+// range{first,last,step} slice specifier for a half-open strided range
+struct range
+{
+    size_t first;
+    size_t last;
+    size_t step = 1;
+};
+
+// all slice specifier for a whole dimension
+struct all_t { explicit all_t() = default; };
+inline constexpr all_t all{};
+}
+
+namespace impl
+{
+template <typename S>
+inline constexpr bool is_slice_spec = std::is_integral_v<S>
+                                   || std::is_same_v<S, array_nd::range>
+                                   || std::is_same_v<S, array_nd::all_t>;
+}
+
+template <typename T, unsigned R>
+requires R != 0 && !std::is_array_v<T> && !std::is_reference_v<T>
+struct array_nd_slice
+{
+    using type            = array_nd_slice;
+    using element_type    = T;
+    using value_type      = std::remove_cv_t<T>;
+    using index_type      = ptrdiff_t;
+    using difference_type = ptrdiff_t;
+    using size_type       = size_t;
+    using pointer         = T*;
+    using reference       = T&;
+
+    static constexpr unsigned rank = R;
+
+    pointer p;
+    std::array<size_t, R> extents;
+    std::array<ptrdiff_t, R> strides;   // in elements
+
+    constexpr size_t extent(unsigned d) const noexcept { return extents[d]; }
+    constexpr ptrdiff_t stride(unsigned d) const noexcept {
+        return strides[d];
+    }
+    constexpr size_t size() const noexcept { return extents[0]; }
+    constexpr bool empty() const noexcept { return size_flat() == 0; }
+    constexpr size_t size_flat() const noexcept
+    {
+        size_t n = 1;
+        for (size_t e : extents)
+            n *= e;
+        return n;
+    }
+    // is_contiguous() true if elements are packed row-major, no gaps
+    constexpr bool is_contiguous() const noexcept
+    {
+        ptrdiff_t s = 1;
+        for (unsigned d = R; d-- != 0; s *= extents[d])
+            if (extents[d] != 1 && strides[d] != s)
+                return false;
+        return true;
+    }
+
+    constexpr decltype(auto) operator[](size_t i) const {
+        return operator()(i);
+    }
+    constexpr decltype(auto) operator()(size_t i) const
+    {
+        if constexpr (R == 1)
+            return p[i*strides[0]];
+        else
+        {
+            array_nd_slice<T, R-1> s{p + i*strides[0], {}, {}};
+            std::copy_n(extents.begin()+1, R-1, s.extents.begin());
+            std::copy_n(strides.begin()+1, R-1, s.strides.begin());
+            return s;
+        }
+    }
+    // (i,j,...) full multi-index element access
+    template <typename... I>
+    requires (sizeof...(I) == R) && (R > 1) && (std::is_integral_v<I> && ...)
+    constexpr reference operator()(I... i) const
+    {
+        ptrdiff_t off = 0;
+        unsigned d = 0;
+        ((off += static_cast<ptrdiff_t>(i) * strides[d++]), ...);
+        return p[off];
+    }
+
+    constexpr void fill(value_type const& e) const;
+
+    // deep copy from any view of same value_type and rank
+    template <typename S>
+    constexpr void assign(S const& src) const;
+
+    // Shallow copy assign only to lvalue slices; so that e.g.
+    // slice(a,...) = {} is an error rather than a silent no-op
+    constexpr array_nd_slice& operator=(array_nd_slice const&) & = default;
+
+    // deep copy of C-array or array_nd_ref rhs to referred-to elements
+    template <typename A>
+    requires std::is_array_v<A> && (std::rank_v<A> == R)
+    constexpr type operator=(A const& rhs) { assign(rhs); return *this; }
+    template <typename A>
+    requires (std::rank_v<A> == R)
+    constexpr type operator=(array_nd_ref<A> rhs) {
+        assign(rhs); return *this;
+    }
+};
+
+namespace impl
+{
+// full_slice(v) the array_nd_slice viewing all of v
+template <typename A>
+constexpr auto full_slice(array_nd_ref<A> r) noexcept
+{
+    using T = std::remove_all_extents_t<A>;
+    constexpr unsigned R = std::rank_v<A>;
+    array_nd_slice<T, R> s{flat(r.a), {}, {}};
+    [&]<size_t... D>(std::index_sequence<D...>) {
+        s.extents = {std::extent_v<A,D>...};
+    }(std::make_index_sequence<R>{});
+    for (unsigned d = 0; d != R; ++d)
+        s.strides[d] = strides<A>[d];
+    return s;
+}
+template <typename T, size_t... X>
+constexpr auto full_slice(array_nd_dyn_ref<T,X...> r) noexcept
+{
+    constexpr unsigned R = sizeof...(X);
+    array_nd_slice<T, R> s{r.p, {}, {}};
+    for (unsigned d = 0; d != R; ++d)
+    {
+        s.extents[d] = r.extent(d);
+        s.strides[d] = r.stride(d);
+    }
+    return s;
+}
+template <typename T, unsigned R>
+constexpr auto full_slice(array_nd_slice<T,R> s) noexcept { return s; }
+template <typename A>
+requires std::is_array_v<A>
+constexpr auto full_slice(A& a) noexcept
+{
+    return full_slice(array_nd_ref<A>{a});
+}
+
+// for_each_row(x,y,f) walks views x and y, of equal extents, in lockstep
+// by rows along the innermost dimension, calling f(px,py,n,sx,sy)
+// for n elements at px, py with strides sx, sy, until f returns false.
+// Views that are both contiguous are walked as a single row.
+template <typename T, typename U, unsigned R, typename F>
+constexpr bool for_each_row(array_nd_slice<T,R> const& x,
+                            array_nd_slice<U,R> const& y, F f)
+{
+    if (x.empty())
+        return true;
+    if (x.is_contiguous() && y.is_contiguous())
+        return f(x.p, y.p, x.size_flat(), ptrdiff_t{1}, ptrdiff_t{1});
+    size_t const n = x.extents[R-1];
+    T* px = x.p;
+    U* py = y.p;
+    std::array<size_t, R> ix{};
+    for (;;)
+    {
+        if (!f(px, py, n, x.strides[R-1], y.strides[R-1]))
+            return false;
+        int d = int(R) - 2;
+        for (; d >= 0; --d)
+        {
+            px += x.strides[d];
+            py += y.strides[d];
+            if (++ix[d] != x.extents[d])
+                break;
+            px -= x.strides[d] * ptrdiff_t(x.extents[d]);
+            py -= y.strides[d] * ptrdiff_t(y.extents[d]);
+            ix[d] = 0;
+        }
+        if (d < 0)
+            return true;
+    }
+}
+}
+
+template <typename T, unsigned R>
+requires R != 0 && !std::is_array_v<T> && !std::is_reference_v<T>
+constexpr void array_nd_slice<T,R>::fill(value_type const& e) const
+{
+    impl::for_each_row(*this, *this,
+        [&e](T* px, T*, size_t n, ptrdiff_t sx, ptrdiff_t) {
+            if (sx == 1)
+                std::fill_n(px, n, e);
+            else
+                for (size_t i = 0; i != n; ++i)
+                    px[i*sx] = e;
+            return true;
+        });
+}
+
+template <typename T, unsigned R>
+requires R != 0 && !std::is_array_v<T> && !std::is_reference_v<T>
+template <typename S>
+constexpr void array_nd_slice<T,R>::assign(S const& src) const
+{
+    auto from = impl::full_slice(src);
+    static_assert(decltype(from)::rank == R,
+                  "array_nd_slice::assign rank mismatch");
+    if (from.extents != extents)
+        throw(std::length_error("array_nd_slice::assign"));
+    impl::for_each_row(*this, from,
+        [](T* px, auto* py, size_t n, ptrdiff_t sx, ptrdiff_t sy) {
+            if (sx == 1 && sy == 1)
+                std::copy_n(py, n, px);
+            else
+                for (size_t i = 0; i != n; ++i)
+                    px[i*sx] = py[i*sy];
+            return true;
+        });
+}
+
+template <typename T, unsigned R, typename U>
+requires std::is_same_v<std::remove_cv_t<T>, std::remove_cv_t<U>>
+constexpr bool
+operator==( array_nd_slice<T,R> const& x, array_nd_slice<U,R> const& y)
+{
+    if (x.extents != y.extents)
+        return false;
+    return impl::for_each_row(x, y,
+        [](T* px, U* py, size_t n, ptrdiff_t sx, ptrdiff_t sy) {
+            if (sx == 1 && sy == 1)
+                return impl::flat_equal(px, py, n);
+            for (size_t i = 0; i != n; ++i)
+                if (!(px[i*sx] == py[i*sy]))
+                    return false;
+            return true;
+        });
+}
+
+// slice(v, specs...) zero-copy strided view of v; see header comment
+template <typename V, typename... S>
+requires (impl::is_slice_spec<S> && ...)
+constexpr decltype(auto) slice(V&& v, S... specs)
+{
+    auto in = impl::full_slice(v);
+    using T = typename decltype(in)::element_type;
+    constexpr unsigned R = decltype(in)::rank;
+    static_assert(sizeof...(S) <= R, "slice: too many slice specifiers");
+    constexpr unsigned Rs = R - (std::is_integral_v<S> + ... + 0);
+
+    T* p = in.p;
+    std::array<size_t, R> ex{};
+    std::array<ptrdiff_t, R> st{};
+    unsigned d = 0, o = 0;
+    [[maybe_unused]] auto apply = [&](auto s) {
+        using Spec = decltype(s);
+        if constexpr (std::is_integral_v<Spec>)
+            p += static_cast<ptrdiff_t>(s) * in.strides[d];
+        else if constexpr (std::is_same_v<Spec, array_nd::range>)
+        {
+            p += static_cast<ptrdiff_t>(s.first) * in.strides[d];
+            ex[o] = s.last > s.first ? (s.last - s.first + s.step-1) / s.step
+                                     : 0;
+            st[o++] = in.strides[d] * static_cast<ptrdiff_t>(s.step);
+        }
+        else
+        {
+            ex[o] = in.extents[d];
+            st[o++] = in.strides[d];
+        }
+        ++d;
+    };
+    (apply(specs), ...);
+    for (; d != R; ++d, ++o)
+    {
+        ex[o] = in.extents[d];
+        st[o] = in.strides[d];
+    }
+    if constexpr (Rs == 0)
+        return *p;
+    else
+    {
+        array_nd_slice<T, Rs> out{p, {}, {}};
+        std::copy_n(ex.begin(), Rs, out.extents.begin());
+        std::copy_n(st.begin(), Rs, out.strides.begin());
+        return out;
+    }
+}
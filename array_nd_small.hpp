@@ -0,0 +1,327 @@
+//    Copyright (c) 2018 Will Wray https://keybase.io/willwray
+//
+//   Distributed under the Boost Software License, Version 1.0.
+//          (http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <type_traits>
+#include <utility>
+
+#include "array_nd_ref.hpp"
+
+/*
+   "array_nd_small.hpp"
+    ^^^^^^^^^^^^^^^^^^
+    Fully unrolled kernels for small fixed matrices, extents 2 to 8,
+    e.g. double[3][3] or float[4][4] transforms; all are constexpr.
+
+  Usage:
+      double m[3][3], inv[3][3];
+      double d = array_nd::determinant(array_nd_ref{m});
+      bool ok = array_nd::inverse(array_nd_ref{m}, array_nd_ref{inv});
+
+  Functions, in namespace array_nd, for square T[N][N], 2 <= N <= 8:
+    determinant(m)   closed form for N <= 4, else elimination, which
+                     is for signed integral or floating point T only
+    inverse(m, r)    r = m^-1, floating point T; closed form (adjugate)
+                     for N <= 4, else Gauss-Jordan with partial pivoting.
+                     Returns false, r untouched, if m is singular.
+  Kernels used by other headers, for both extents in [2,8]:
+    impl::small_matmul   via array_nd::matmul, "array_nd_matmul.hpp"
+    impl::small_transpose via array_nd::transpose, "array_nd_transpose.hpp"
+  Equality of up to 64 arithmetic elements is also unrolled, branch-free,
+  in array_nd_ref operator==.
+
+  Unrolling is by index sequence pack expansion, so there is no loop
+  or index arithmetic left at runtime and constant indices also serve
+  the hierarchical access that constant evaluation needs. The closed
+  forms are evaluated in the natural order, so results are the same
+  in constant evaluation and at runtime.
+*/
+namespace impl
+{
+// small_extent(n) extent n is handled by the unrolled kernels
+constexpr bool small_extent(size_t n) { return 2 <= n && n <= 8; }
+
+template <typename A>
+concept bool small_matrix = std::rank_v<A> == 2
+                         && small_extent(std::extent_v<A,0>)
+                         && small_extent(std::extent_v<A,1>);
+
+// unroll<N>(f) calls f(std::integral_constant<size_t,I>{}), I in [0,N)
+template <size_t N, typename F>
+constexpr void unroll(F&& f)
+{
+    [&]<size_t... I>(std::index_sequence<I...>) {
+        (f(std::integral_constant<size_t,I>{}), ...);
+    }(std::make_index_sequence<N>{});
+}
+
+// small_matmul(c,a,b) c = a b via a local tile, so c may alias a or b
+template <typename C, typename A, typename B>
+constexpr void small_matmul(array_nd_ref<C> c,
+                            array_nd_ref<A> a, array_nd_ref<B> b)
+{
+    constexpr size_t M = std::extent_v<A,0>, K = std::extent_v<A,1>,
+                     N = std::extent_v<B,1>;
+    using T = std::remove_all_extents_t<C>;
+    T r[M][N] {};
+    unroll<M*N>([&](auto ij) {
+        constexpr size_t i = ij / N, j = ij % N;
+        r[i][j] = [&]<size_t... k>(std::index_sequence<k...>) {
+            return (... + (a[i][k] * b[k][j]));
+        }(std::make_index_sequence<K>{});
+    });
+    unroll<M*N>([&](auto ij) { c[ij / N][ij % N] = r[ij / N][ij % N]; });
+}
+
+// small_transpose(src,dst) dst = src^T, src and dst must not overlap
+template <typename A, typename B>
+constexpr void small_transpose(array_nd_ref<A> src, array_nd_ref<B> dst)
+{
+    constexpr size_t M = std::extent_v<A,0>, N = std::extent_v<A,1>;
+    unroll<M*N>([&](auto ij) { dst[ij % N][ij / N] = src[ij / N][ij % N]; });
+}
+
+// small_transpose(a) in-place, square
+template <typename T, size_t N>
+constexpr void small_transpose(array_nd_ref<T[N][N]> a)
+{
+    unroll<N*N>([&](auto ij) {
+        constexpr size_t i = ij / N, j = ij % N;
+        if constexpr (i < j)
+            std::swap(a[i][j], a[j][i]);
+    });
+}
+
+// det_eliminate(m) determinant of local copy m by elimination:
+// partial pivoting LU for floating point, fraction-free Bareiss
+// (exact division) for signed integers. The k, i, j loops unroll;
+// only the pivot row is data-dependent.
+template <typename T, size_t N>
+requires std::is_signed_v<T>
+constexpr T det_eliminate(T (&m)[N][N])
+{
+    T det = 1, prev = 1;
+    bool singular = false;
+    unroll<N>([&](auto kc) {
+        constexpr size_t k = kc;
+        if (singular)
+            return;
+        // floating point: largest magnitude; else first nonzero
+        size_t p = k;
+        unroll<N>([&](auto i) {
+            if constexpr (i > k)
+            {
+                if constexpr (std::is_floating_point_v<T>)
+                {
+                    if ((m[i][k] < 0 ? -m[i][k] : m[i][k])
+                      > (m[p][k] < 0 ? -m[p][k] : m[p][k]))
+                        p = i;
+                }
+                else if (m[p][k] == T(0))
+                    p = i;
+            }
+        });
+        if (m[p][k] == T(0))
+        {
+            singular = true;
+            return;
+        }
+        if (p != k)
+        {
+            std::swap(m[p], m[k]);
+            det = -det;
+        }
+        unroll<N>([&](auto i) {
+            if constexpr (i > k)
+            {
+                if constexpr (std::is_floating_point_v<T>)
+                {
+                    T const f = m[i][k] / m[k][k];
+                    unroll<N>([&](auto j) {
+                        if constexpr (j > k)
+                            m[i][j] -= f * m[k][j];
+                    });
+                }
+                else
+                    unroll<N>([&](auto j) {
+                        if constexpr (j > k)
+                            m[i][j] = (m[i][j] * m[k][k] - m[i][k] * m[k][j])
+                                    / prev;
+                    });
+            }
+        });
+        if constexpr (std::is_floating_point_v<T>)
+            det *= m[k][k];
+        else
+            prev = m[k][k];
+    });
+    if (singular)
+        return T(0);
+    if constexpr (std::is_floating_point_v<T>)
+        return det;
+    else
+        return det * prev;
+}
+}
+
+namespace array_nd
+{
+// determinant(m) of square matrix m, closed form for N <= 4;
+// elimination, for N > 4, needs signed or floating point T
+template <typename T, size_t N>
+requires (impl::small_extent(N))
+      && (N <= 4 || std::is_signed_v<std::remove_cv_t<T>>)
+constexpr auto determinant(array_nd_ref<T[N][N]> m)
+{
+    using V = std::remove_cv_t<T>;
+    auto const& a = m;
+    if constexpr (N == 2)
+        return V(a[0][0]*a[1][1] - a[0][1]*a[1][0]);
+    else if constexpr (N == 3)
+        return V(a[0][0] * (a[1][1]*a[2][2] - a[1][2]*a[2][1])
+               - a[0][1] * (a[1][0]*a[2][2] - a[1][2]*a[2][0])
+               + a[0][2] * (a[1][0]*a[2][1] - a[1][1]*a[2][0]));
+    else if constexpr (N == 4)
+    {
+        V const s0 = a[0][0]*a[1][1] - a[1][0]*a[0][1];
+        V const s1 = a[0][0]*a[1][2] - a[1][0]*a[0][2];
+        V const s2 = a[0][0]*a[1][3] - a[1][0]*a[0][3];
+        V const s3 = a[0][1]*a[1][2] - a[1][1]*a[0][2];
+        V const s4 = a[0][1]*a[1][3] - a[1][1]*a[0][3];
+        V const s5 = a[0][2]*a[1][3] - a[1][2]*a[0][3];
+        V const c5 = a[2][2]*a[3][3] - a[3][2]*a[2][3];
+        V const c4 = a[2][1]*a[3][3] - a[3][1]*a[2][3];
+        V const c3 = a[2][1]*a[3][2] - a[3][1]*a[2][2];
+        V const c2 = a[2][0]*a[3][3] - a[3][0]*a[2][3];
+        V const c1 = a[2][0]*a[3][2] - a[3][0]*a[2][2];
+        V const c0 = a[2][0]*a[3][1] - a[3][0]*a[2][1];
+        return V(s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0);
+    }
+    else
+    {
+        V w[N][N] {};
+        impl::unroll<N*N>([&](auto ij) { w[ij / N][ij % N] = a[ij / N][ij % N]; });
+        return impl::det_eliminate(w);
+    }
+}
+
+// inverse(m,r) r = m^-1 for floating point m; false if m is singular
+template <typename T, size_t N, typename R>
+requires (impl::small_extent(N))
+      && std::is_floating_point_v<std::remove_cv_t<T>>
+      && std::is_same_v<R, std::remove_cv_t<T>[N][N]>
+constexpr bool inverse(array_nd_ref<T[N][N]> m, array_nd_ref<R> r)
+{
+    using V = std::remove_cv_t<T>;
+    auto const& a = m;
+    V w[N][N] {};
+    if constexpr (N == 2)
+    {
+        V const d = determinant(m);
+        if (d == V(0))
+            return false;
+        w[0][0] =  a[1][1] / d;  w[0][1] = -a[0][1] / d;
+        w[1][0] = -a[1][0] / d;  w[1][1] =  a[0][0] / d;
+    }
+    else if constexpr (N == 3)
+    {
+        V const d = determinant(m);
+        if (d == V(0))
+            return false;
+        // adjugate: w[j][i] is the (i,j) cofactor
+        impl::unroll<9>([&](auto ij) {
+            constexpr size_t i = ij / 3, j = ij % 3;
+            constexpr size_t i0 = (i+1) % 3, i1 = (i+2) % 3,
+                             j0 = (j+1) % 3, j1 = (j+2) % 3;
+            w[j][i] = (a[i0][j0]*a[i1][j1] - a[i0][j1]*a[i1][j0]) / d;
+        });
+    }
+    else if constexpr (N == 4)
+    {
+        V const s0 = a[0][0]*a[1][1] - a[1][0]*a[0][1];
+        V const s1 = a[0][0]*a[1][2] - a[1][0]*a[0][2];
+        V const s2 = a[0][0]*a[1][3] - a[1][0]*a[0][3];
+        V const s3 = a[0][1]*a[1][2] - a[1][1]*a[0][2];
+        V const s4 = a[0][1]*a[1][3] - a[1][1]*a[0][3];
+        V const s5 = a[0][2]*a[1][3] - a[1][2]*a[0][3];
+        V const c5 = a[2][2]*a[3][3] - a[3][2]*a[2][3];
+        V const c4 = a[2][1]*a[3][3] - a[3][1]*a[2][3];
+        V const c3 = a[2][1]*a[3][2] - a[3][1]*a[2][2];
+        V const c2 = a[2][0]*a[3][3] - a[3][0]*a[2][3];
+        V const c1 = a[2][0]*a[3][2] - a[3][0]*a[2][2];
+        V const c0 = a[2][0]*a[3][1] - a[3][0]*a[2][1];
+        V const d = s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0;
+        if (d == V(0))
+            return false;
+        V const id = V(1) / d;
+        w[0][0] = ( a[1][1]*c5 - a[1][2]*c4 + a[1][3]*c3) * id;
+        w[0][1] = (-a[0][1]*c5 + a[0][2]*c4 - a[0][3]*c3) * id;
+        w[0][2] = ( a[3][1]*s5 - a[3][2]*s4 + a[3][3]*s3) * id;
+        w[0][3] = (-a[2][1]*s5 + a[2][2]*s4 - a[2][3]*s3) * id;
+        w[1][0] = (-a[1][0]*c5 + a[1][2]*c2 - a[1][3]*c1) * id;
+        w[1][1] = ( a[0][0]*c5 - a[0][2]*c2 + a[0][3]*c1) * id;
+        w[1][2] = (-a[3][0]*s5 + a[3][2]*s2 - a[3][3]*s1) * id;
+        w[1][3] = ( a[2][0]*s5 - a[2][2]*s2 + a[2][3]*s1) * id;
+        w[2][0] = ( a[1][0]*c4 - a[1][1]*c2 + a[1][3]*c0) * id;
+        w[2][1] = (-a[0][0]*c4 + a[0][1]*c2 - a[0][3]*c0) * id;
+        w[2][2] = ( a[3][0]*s4 - a[3][1]*s2 + a[3][3]*s0) * id;
+        w[2][3] = (-a[2][0]*s4 + a[2][1]*s2 - a[2][3]*s0) * id;
+        w[3][0] = (-a[1][0]*c3 + a[1][1]*c1 - a[1][2]*c0) * id;
+        w[3][1] = ( a[0][0]*c3 - a[0][1]*c1 + a[0][2]*c0) * id;
+        w[3][2] = (-a[3][0]*s3 + a[3][1]*s1 - a[3][2]*s0) * id;
+        w[3][3] = ( a[2][0]*s3 - a[2][1]*s1 + a[2][2]*s0) * id;
+    }
+    else
+    {
+        // Gauss-Jordan on [u | w], u a copy of m, w from identity
+        V u[N][N] {};
+        impl::unroll<N*N>([&](auto ij) {
+            constexpr size_t i = ij / N, j = ij % N;
+            u[i][j] = a[i][j];
+            w[i][j] = V(i == j);
+        });
+        bool singular = false;
+        impl::unroll<N>([&](auto kc) {
+            constexpr size_t k = kc;
+            if (singular)
+                return;
+            size_t p = k;
+            impl::unroll<N>([&](auto i) {
+                if constexpr (i > k)
+                    if ((u[i][k] < 0 ? -u[i][k] : u[i][k])
+                      > (u[p][k] < 0 ? -u[p][k] : u[p][k]))
+                        p = i;
+            });
+            if (u[p][k] == V(0))
+            {
+                singular = true;
+                return;
+            }
+            std::swap(u[p], u[k]);
+            std::swap(w[p], w[k]);
+            V const ip = V(1) / u[k][k];
+            impl::unroll<N>([&](auto j) {
+                u[k][j] *= ip;
+                w[k][j] *= ip;
+            });
+            impl::unroll<N>([&](auto i) {
+                if constexpr (i != k)
+                {
+                    V const f = u[i][k];
+                    impl::unroll<N>([&](auto j) {
+                        u[i][j] -= f * u[k][j];
+                        w[i][j] -= f * w[k][j];
+                    });
+                }
+            });
+        });
+        if (singular)
+            return false;
+    }
+    impl::unroll<N*N>([&](auto ij) { r[ij / N][ij % N] = w[ij / N][ij % N]; });
+    return true;
+}
+}
@@ -0,0 +1,304 @@
+//    Copyright (c) 2018 Will Wray https://keybase.io/willwray
+//
+//   Distributed under the Boost Software License, Version 1.0.
+//          (http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "array_nd_ref.hpp"
+#include "array_nd_small.hpp"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/*
+   "array_nd_transpose.hpp"
+    ^^^^^^^^^^^^^^^^^^^^^^
+    Cache-oblivious matrix transpose for rank 2 array_nd_ref.
+
+  Usage:
+      array_nd::transpose(array_nd_ref{sq});        // in-place, T[N][N]
+      array_nd::transpose(array_nd_ref{a}, array_nd_ref{b});
+                                 // out-of-place, T[M][N] to T[N][M]
+
+  Implementation:
+    Recursive blocking halves the longer dimension until blocks fit in
+    L1 cache, then transposes register tiles:
+      8x8 of 4-byte (float, int) elements with AVX,
+      4x4 of 4-byte elements with SSE2, 4x4 of double with AVX or SSE2,
+      scalar tiles for other element types or ISAs, and at the edges.
+    ISA is chosen at compile time by the predefined __SSE2__, __AVX__.
+    In-place transpose swaps off-diagonal tile pairs via an L1 buffer.
+    Constant evaluation uses the plain double loop.
+    Small matrices, extents 2 to 8, are fully unrolled at compile time,
+    see "array_nd_small.hpp".
+*/
+namespace impl
+{
+// Register tile kernels transpose a KxK tile from src, row stride ss,
+// to dst, row stride ds. All loads precede all stores so src may be dst.
+template <size_t K, typename T>
+inline void transpose_tile(T const* src, size_t ss, T* dst, size_t ds)
+{
+    T t[K][K];
+    for (size_t i = 0; i != K; ++i)
+        for (size_t j = 0; j != K; ++j)
+            t[j][i] = src[i*ss + j];
+    for (size_t i = 0; i != K; ++i)
+        std::copy_n(t[i], K, dst + i*ds);
+}
+
+#if defined(__SSE2__)
+inline void transpose_4x4_32(void const* s, size_t ss, void* d, size_t ds)
+{
+    auto src = static_cast<float const*>(s);
+    auto dst = static_cast<float*>(d);
+    __m128 r0 = _mm_loadu_ps(src), r1 = _mm_loadu_ps(src + ss),
+           r2 = _mm_loadu_ps(src + 2*ss), r3 = _mm_loadu_ps(src + 3*ss);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(dst, r0);        _mm_storeu_ps(dst + ds, r1);
+    _mm_storeu_ps(dst + 2*ds, r2); _mm_storeu_ps(dst + 3*ds, r3);
+}
+
+inline void transpose_4x4_64(void const* s, size_t ss, void* d, size_t ds)
+{
+    auto src = static_cast<double const*>(s);
+    auto dst = static_cast<double*>(d);
+#if defined(__AVX__)
+    __m256d r0 = _mm256_loadu_pd(src),        r1 = _mm256_loadu_pd(src+ss),
+            r2 = _mm256_loadu_pd(src + 2*ss), r3 = _mm256_loadu_pd(src+3*ss);
+    __m256d t0 = _mm256_unpacklo_pd(r0, r1), t1 = _mm256_unpackhi_pd(r0, r1),
+            t2 = _mm256_unpacklo_pd(r2, r3), t3 = _mm256_unpackhi_pd(r2, r3);
+    _mm256_storeu_pd(dst,        _mm256_permute2f128_pd(t0, t2, 0x20));
+    _mm256_storeu_pd(dst + ds,   _mm256_permute2f128_pd(t1, t3, 0x20));
+    _mm256_storeu_pd(dst + 2*ds, _mm256_permute2f128_pd(t0, t2, 0x31));
+    _mm256_storeu_pd(dst + 3*ds, _mm256_permute2f128_pd(t1, t3, 0x31));
+#else
+    // four 2x2 blocks; r[i][h] is row i, columns 2h, 2h+1
+    __m128d r[4][2];
+    for (size_t i = 0; i != 4; ++i)
+        for (size_t h = 0; h != 2; ++h)
+            r[i][h] = _mm_loadu_pd(src + i*ss + 2*h);
+    for (size_t i = 0; i != 4; i += 2)
+        for (size_t h = 0; h != 2; ++h)
+        {
+            _mm_storeu_pd(dst + (2*h)*ds + i,
+                          _mm_unpacklo_pd(r[i][h], r[i+1][h]));
+            _mm_storeu_pd(dst + (2*h+1)*ds + i,
+                          _mm_unpackhi_pd(r[i][h], r[i+1][h]));
+        }
+#endif
+}
+#endif
+
+#if defined(__AVX__)
+inline void transpose_8x8_32(void const* s, size_t ss, void* d, size_t ds)
+{
+    auto src = static_cast<float const*>(s);
+    auto dst = static_cast<float*>(d);
+    __m256 r[8], t[8];
+    for (size_t i = 0; i != 8; ++i)
+        r[i] = _mm256_loadu_ps(src + i*ss);
+    for (size_t i = 0; i != 8; i += 2)
+    {
+        t[i]   = _mm256_unpacklo_ps(r[i], r[i+1]);
+        t[i+1] = _mm256_unpackhi_ps(r[i], r[i+1]);
+    }
+    for (size_t i = 0; i != 8; i += 4)
+    {
+        r[i]   = _mm256_shuffle_ps(t[i],   t[i+2], 0x44);
+        r[i+1] = _mm256_shuffle_ps(t[i],   t[i+2], 0xEE);
+        r[i+2] = _mm256_shuffle_ps(t[i+1], t[i+3], 0x44);
+        r[i+3] = _mm256_shuffle_ps(t[i+1], t[i+3], 0xEE);
+    }
+    for (size_t i = 0; i != 4; ++i)
+    {
+        _mm256_storeu_ps(dst + i*ds,
+                         _mm256_permute2f128_ps(r[i], r[i+4], 0x20));
+        _mm256_storeu_ps(dst + (i+4)*ds,
+                         _mm256_permute2f128_ps(r[i], r[i+4], 0x31));
+    }
+}
+#endif
+
+// transpose_kernel<T>::size is the edge of the register tile for
+// element type T and tile(src,ss,dst,ds) transposes one such tile
+template <typename T>
+struct transpose_kernel
+{
+    static constexpr bool is_simd32 = sizeof(T) == 4
+                        && (std::is_arithmetic_v<T> || std::is_enum_v<T>);
+    static constexpr bool is_simd64 = sizeof(T) == 8
+                        && (std::is_arithmetic_v<T> || std::is_enum_v<T>);
+#if defined(__AVX__)
+    static constexpr size_t size = is_simd32 ? 8 : 4;
+#else
+    static constexpr size_t size = 4;
+#endif
+    static void tile(T const* src, size_t ss, T* dst, size_t ds)
+    {
+#if defined(__AVX__)
+        if constexpr (is_simd32)
+            return transpose_8x8_32(src, ss, dst, ds);
+#elif defined(__SSE2__)
+        if constexpr (is_simd32)
+            return transpose_4x4_32(src, ss, dst, ds);
+#endif
+#if defined(__SSE2__)
+        if constexpr (is_simd64)
+            return transpose_4x4_64(src, ss, dst, ds);
+#endif
+        transpose_tile<size>(src, ss, dst, ds);
+    }
+};
+
+// Recursion stops at blocks of this many bytes, per operand, to fit L1
+inline constexpr size_t transpose_leaf_bytes = 8 * 1024;
+
+// transpose_rect copies the transpose of block rows [i0,i1), columns
+// [j0,j1) of src (row stride ss) into dst (row stride ds)
+template <typename T>
+void transpose_rect(T const* src, size_t ss, T* dst, size_t ds,
+                    size_t i0, size_t i1, size_t j0, size_t j1)
+{
+    using kernel = transpose_kernel<T>;
+    constexpr size_t K = kernel::size;
+    size_t const di = i1 - i0, dj = j1 - j0;
+    if (di * dj * sizeof(T) > transpose_leaf_bytes && (di > K || dj > K))
+    {
+        if (di >= dj)
+        {
+            size_t const im = i0 + (di/2 + K-1) / K * K;
+            transpose_rect(src, ss, dst, ds, i0, im, j0, j1);
+            transpose_rect(src, ss, dst, ds, im, i1, j0, j1);
+        }
+        else
+        {
+            size_t const jm = j0 + (dj/2 + K-1) / K * K;
+            transpose_rect(src, ss, dst, ds, i0, i1, j0, jm);
+            transpose_rect(src, ss, dst, ds, i0, i1, jm, j1);
+        }
+        return;
+    }
+    size_t i = i0;
+    for (; i + K <= i1; i += K)
+    {
+        size_t j = j0;
+        for (; j + K <= j1; j += K)
+            kernel::tile(src + i*ss + j, ss, dst + j*ds + i, ds);
+        for (; j != j1; ++j)
+            for (size_t r = i; r != i + K; ++r)
+                dst[j*ds + r] = src[r*ss + j];
+    }
+    for (; i != i1; ++i)
+        for (size_t j = j0; j != j1; ++j)
+            dst[j*ds + i] = src[i*ss + j];
+}
+
+// transpose_square_rect transposes in place the block rows [i0,i1),
+// columns [j0,j1) of square matrix a, N x N, with block [j0,j1)x[i0,i1);
+// a diagonal block (i0 == j0) is transposed on its own.
+template <typename T>
+void transpose_square_rect(T* a, size_t N,
+                           size_t i0, size_t i1, size_t j0, size_t j1)
+{
+    using kernel = transpose_kernel<T>;
+    constexpr size_t K = kernel::size;
+    size_t const di = i1 - i0, dj = j1 - j0;
+    if (2 * di * dj * sizeof(T) > transpose_leaf_bytes && (di > K || dj > K))
+    {
+        if (di >= dj)
+        {
+            size_t const im = i0 + (di/2 + K-1) / K * K;
+            if (i0 == j0)   // diagonal: two diagonal blocks, one pair
+            {
+                transpose_square_rect(a, N, i0, im, i0, im);
+                transpose_square_rect(a, N, im, i1, i0, im);
+                transpose_square_rect(a, N, im, i1, im, i1);
+                return;
+            }
+            transpose_square_rect(a, N, i0, im, j0, j1);
+            transpose_square_rect(a, N, im, i1, j0, j1);
+        }
+        else
+        {
+            size_t const jm = j0 + (dj/2 + K-1) / K * K;
+            transpose_square_rect(a, N, i0, i1, j0, jm);
+            transpose_square_rect(a, N, i0, i1, jm, j1);
+        }
+        return;
+    }
+    bool const diag = i0 == j0;
+    size_t i = i0;
+    for (; i + K <= i1; i += K)
+    {
+        size_t j = diag ? i : j0;
+        if (diag)       // diagonal tile in place
+        {
+            kernel::tile(a + i*N + i, N, a + i*N + i, N);
+            j += K;
+        }
+        for (; j + K <= j1; j += K)
+        {
+            T t[K*K];
+            kernel::tile(a + i*N + j, N, t, K);
+            kernel::tile(a + j*N + i, N, a + i*N + j, N);
+            for (size_t r = 0; r != K; ++r)
+                std::copy_n(t + r*K, K, a + (j+r)*N + i);
+        }
+        for (; j != j1; ++j)
+            for (size_t r = i; r != i + K; ++r)
+                std::swap(a[r*N + j], a[j*N + r]);
+    }
+    for (; i != i1; ++i)
+        for (size_t j = diag ? i+1 : j0; j != j1; ++j)
+            std::swap(a[i*N + j], a[j*N + i]);
+}
+}
+
+namespace array_nd
+{
+// transpose(a) in-place transpose of square matrix a
+template <typename T, size_t N>
+requires (!std::is_const_v<T>)
+constexpr array_nd_ref<T[N][N]> transpose(array_nd_ref<T[N][N]> a)
+{
+    if constexpr (impl::small_extent(N))
+        impl::small_transpose(a);
+    else if (std::is_constant_evaluated())
+    {
+        for (size_t i = 0; i != N; ++i)
+            for (size_t j = i+1; j != N; ++j)
+                std::swap(a[i][j], a[j][i]);
+    }
+    else
+        impl::transpose_square_rect(impl::flat(a.a), N, 0, N, 0, N);
+    return a;
+}
+
+// transpose(src,dst) out-of-place transpose, T[M][N] to T[N][M];
+// src and dst must not overlap
+template <typename A, typename B>
+requires (std::rank_v<A> == 2) && (std::rank_v<B> == 2)
+      && (std::extent_v<A,0> == std::extent_v<B,1>)
+      && (std::extent_v<A,1> == std::extent_v<B,0>)
+      && std::is_same_v<std::remove_cv_t<std::remove_all_extents_t<A>>,
+                        std::remove_all_extents_t<B>>
+constexpr array_nd_ref<B> transpose(array_nd_ref<A> src, array_nd_ref<B> dst)
+{
+    constexpr size_t M = std::extent_v<A,0>, N = std::extent_v<A,1>;
+    if constexpr (impl::small_matrix<A>)
+        impl::small_transpose(src, dst);
+    else if (std::is_constant_evaluated())
+    {
+        for (size_t i = 0; i != M; ++i)
+            for (size_t j = 0; j != N; ++j)
+                dst[j][i] = src[i][j];
+    }
+    else
+        impl::transpose_rect(impl::flat(src.a), N, impl::flat(dst.a), M,
+                             0, M, 0, N);
+    return dst;
+}
+}
@@ -1,6 +1,14 @@
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <numeric>
+#include <vector>
 
 #include "array_nd_ref.hpp"
+#include "array_nd.hpp"
+
+#include <cstdint>
+#include <string>
 // https://wandbox.org/permlink/z2KooPw02pbj1hyC
 template <typename> struct wotype;
 
@@ -306,6 +314,94 @@ int main()
     bool check_neq = array_nd_ref{a} != b;
     assert( check_neq);
 }
+// mismatch position, flat and multi-index
+{
+    static int a[5][6][7]{};
+    static int b[5][6][7]{};
+    auto m = mismatch(array_nd_ref{a}, array_nd_ref{b});
+    assert(!m && m.index == 5*6*7);
+    assert((m.indices == std::array<size_t,3>{5,0,0}));
+
+    b[4][2][3] = 1;
+    m = mismatch(array_nd_ref{a}, array_nd_ref{b});
+    assert(m && m.index == 4*42 + 2*7 + 3);
+    assert((m.indices == std::array<size_t,3>{4,2,3}));
+    assert(array_nd_ref{a} != b);
+
+    double x[3][100]{};
+    double y[3][100]{};
+    y[2][99] = 0.5;
+    assert(mismatch(array_nd_ref{x}, array_nd_ref{y}).index == 299);
+    y[2][99] = -0.0;    // -0.0 == 0.0, though not bitwise equal
+    assert(array_nd_ref{x} == y);
+
+    static constexpr int c[2][3]{{1,2,3},{4,5,6}};
+    static constexpr int d[2][3]{{1,2,3},{4,0,6}};
+    static_assert(mismatch(array_nd_ref{c}, array_nd_ref{d}).index == 4);
+    static_assert(mismatch(array_nd_ref{c}, array_nd_ref{d}).indices[1] == 1);
+    static_assert(array_nd_ref{c} != d);
+}
+// flat elements() range
+{
+    using E = array_nd_elements<int[2][3]>;
+    static_assert(std::contiguous_iterator<E::iterator>);
+    static_assert(std::is_same_v<decltype(*E{}.begin()), int&>);
+    static_assert(std::is_same_v<decltype(*array_nd_ref<int const[2][3]>{
+                    nullptr}.elements().begin()), int const&>);
+
+    int a[2][3][4];
+    auto e = array_nd_ref{a}.elements();
+    assert(e.size() == 24 && e.end() - e.begin() == 24);
+    std::iota(e.begin(), e.end(), 0);
+    assert(a[0][0][0] == 0 && a[1][0][0] == 12 && a[1][2][3] == 23);
+    assert(std::accumulate(e.begin(), e.end(), 0) == 23*24/2);
+    assert(e.data() == &a[0][0][0] && std::to_address(e.end()) == e.data()+24);
+    assert(std::find(e.begin(), e.end(), 17) - e.begin() == 17);
+    assert(e[13] == a[1][0][1]);
+
+    static constexpr int c[2][2][2]{{{1,2},{3,4}},{{5,6},{7,8}}};
+    constexpr auto ce = array_nd_ref{c}.elements();
+    static_assert(std::accumulate(ce.begin(), ce.end(), 0) == 36);
+    static_assert(*(ce.end() - 1) == 8 && ce[5] == 6);
+
+    constexpr int product = []{
+        int b[3][3]{};
+        auto be = array_nd_ref{b}.elements();
+        for (int i = 0; auto& x : be)
+            x = i++;
+        return b[2][2] * b[1][1];
+    }();
+    static_assert(product == 32);
+}
+// three-way comparison, lexicographic as-if flat
+{
+    static int keys[3][2][2][2]{
+        {{{1,2},{3,4}},{{5,6},{7,8}}},
+        {{{1,2},{3,4}},{{5,6},{7,0}}},
+        {{{0,9},{9,9}},{{9,9},{9,9}}}};
+    auto k0 = array_nd_ref{keys[0]};
+    auto k1 = array_nd_ref{keys[1]};
+    auto k2 = array_nd_ref{keys[2]};
+    static_assert(std::is_same_v<decltype(k0 <=> k1), std::strong_ordering>);
+    assert((k0 <=> k0) == 0);
+    assert((k1 <=> k0) < 0 && k1 < k0 && k0 > k1 && k1 <= k0 && k0 >= k1);
+    assert(k2 < k1 && k2 < keys[0] && k0 >= keys[1] && k0 <= keys[0]);
+
+    std::vector<array_nd_ref<int[2][2][2]>> v{k0, k1, k2};
+    std::sort(v.begin(), v.end());
+    assert(v[0].a == k2.a && v[1].a == k1.a && v[2].a == k0.a);
+
+    double x[2][2]{{1,2},{3,NAN}};
+    double y[2][2]{{1,2},{3,NAN}};
+    auto xr = array_nd_ref{x};
+    static_assert(std::is_same_v<decltype(xr <=> y),std::partial_ordering>);
+    assert((xr <=> y) == std::partial_ordering::unordered);
+    y[1][0] = 4;
+    assert(xr < y);
+
+    static_assert( array_nd_ref{"A++"} < "C++");
+    static_assert( (array_nd_ref{"C++"} <=> "C++") == 0);
+}
 // structured binding
 {
     char cstr[][4]{"C++","++C"};
@@ -349,6 +445,35 @@ int main()
     static_assert(!std::tuple_element_t<0,Tr>{});
 
 }
+// test flat fill and deep copy, runtime and constexpr
+{
+    static double d[4][8][2];
+    array_nd_ref{d}.fill(0.0);              // all-zero bytes: memset
+    assert(d[0][0][0] == 0.0 && d[3][7][1] == 0.0);
+    array_nd_ref{d}.fill(1.5);              // multi-byte pattern
+    assert(d[0][0][0] == 1.5 && d[2][5][1] == 1.5 && d[3][7][1] == 1.5);
+
+    double e[4][8][2]{};
+    e[3][7][1] = -1;
+    array_nd_ref{d} = e;
+    assert(d[0][0][0] == 0 && d[3][7][1] == -1);
+    assert(array_nd_ref{d} == e);
+
+    constexpr auto filled = []{
+        int a[2][3]{};
+        array_nd_ref{a}.fill(7);
+        return a[1][2];
+    }();
+    static_assert(filled == 7);
+
+    constexpr auto copied = []{
+        int a[2][3]{};
+        int const b[2][3]{{1,2,3},{4,5,6}};
+        array_nd_ref{a} = b;
+        return a[1][2];
+    }();
+    static_assert(copied == 6);
+}
 // test operator= copy assign
 {
     using c24 = char[2][4];
@@ -401,4 +526,95 @@ int main()
     static_assert (std::is_same_v<decltype(*it), int(&)[3] >);
     static_assert (std::is_same_v<decltype(it[0]), int(&)[3] >);
 }
+// multi-index (i,j,k...), full index flat, partial index subarray
+{
+    static int a[3][4][5];
+    auto ae = array_nd_ref{a}.elements();
+    std::iota(ae.begin(), ae.end(), 0);
+    auto r = array_nd_ref{a};
+    assert(r(2,3,4) == 59 && &r(1,2,3) == &a[1][2][3]);
+    r(0,1,2) = -1;
+    assert(a[0][1][2] == -1);
+    static_assert(std::is_same_v<decltype(r(1,2)), array_nd_ref<int[5]>>);
+    assert(r(1,2).a == a[1][2] && r(2,1)[4] == a[2][1][4]);
+
+    constexpr auto ci = []{
+        int b[2][3][2] {{{0,1},{2,3},{4,5}},{{6,7},{8,9},{10,11}}};
+        return array_nd_ref{b}(1,2,1) * 100 + array_nd_ref{b}(1,1)(0);
+    }();
+    static_assert(ci == 1108);
+#if defined(__cpp_multidimensional_subscript)
+    assert((r[2,3,4] == 59 && &r[1,2] == &a[1][2]));
+#endif
+}
+// reshape views
+{
+    static float m[64][64];
+    auto r = array_nd_ref{m};
+    auto flat = reshape<float[4096]>(r);
+    static_assert(std::is_same_v<decltype(flat), array_nd_ref<float[4096]>>);
+    flat[64*3 + 5] = 1.f;
+    assert(m[3][5] == 1.f);
+    auto r3 = reshape<float[16][4][64]>(r);
+    assert(&r3(15,3,63) == &m[63][63] && &r3(0,1,0) == &m[1][0]);
+
+    float const (&cm)[64][64] = m;
+    auto cf = reshape<float[2][2048]>(array_nd_ref<float const[64][64]>{cm});
+    static_assert(std::is_same_v<decltype(cf),
+                                 array_nd_ref<float const[2][2048]>>);
+    assert(cf[0][64*3 + 5] == 1.f);
+
+    constexpr auto same = []{
+        int a[2][3] {{1,2,3},{4,5,6}};
+        return reshape<int[2][3]>(array_nd_ref{a})[1][2];
+    }();
+    static_assert(same == 6);
+}
+// owning array_nd::array
+{
+    auto aligned = [](auto const& a, size_t align) {
+        return reinterpret_cast<std::uintptr_t>(&a) % align == 0;
+    };
+    array_nd::array<double[3][5]> m;
+    static_assert(m.alignment == 64 && m.rank == 2 && m.extent == 3);
+    assert(aligned(m.data(), 64));
+    assert(m[2][4] == 0.0); // value-initialized
+
+    array_nd_ref<double[3][5]> r = m;
+    array_nd_ref<double const[3][5]> cr = std::as_const(m);
+    r.fill(2.0);
+    assert(m[1][1] == 2.0 && cr[2][4] == 2.0 && r.a == &m.data()[0]);
+
+    auto n = m;                 // deep copy
+    assert(n == m && &n.data() != &m.data());
+    n(1)(1) = 3.0;
+    assert(n != m && m < n);
+    m = n;
+    assert(m[1][1] == 3.0);
+
+    auto o = std::move(n);      // steals
+    assert(o[1][1] == 3.0);
+    n = o;                      // moved-from is assignable
+    assert(n == o);
+    auto e = std::move(n);
+    auto f = n;                 // copies of moved-from have no storage
+    m = n;                      // nor does assignment from moved-from
+    f = e;
+    m = f;
+    assert(f == e && m == e);
+
+    array_nd::array<int[4][1024], array_nd::page_align> pg{};
+    assert(aligned(pg.data(), 4096));
+    pg.elements()[4095] = 7;
+    assert(pg[3][1023] == 7);
+
+    array_nd::array<char[3][1<<20], array_nd::huge_page_align> hp;
+    assert(aligned(hp.data(), array_nd::huge_page_align));
+    hp.fill('x');
+    assert(hp[2][(1<<20)-1] == 'x');
+
+    array_nd::array<std::string[2][2]> s({{"a","b"},{"c","d"}});
+    auto t = s;
+    assert(t[1][0] == "c" && t == s);
+}
 }
\ No newline at end of file
@@ -0,0 +1,83 @@
+#include <cassert>
+#include <stdexcept>
+#include <vector>
+
+#include "array_nd_dyn_ref.hpp"
+
+using array_nd::dyn;
+
+int main()
+{
+// static extents are free, dynamic extents stored
+{
+    static_assert(sizeof(array_nd_dyn_ref<int, 2, 3>) == sizeof(int*));
+    static_assert(sizeof(array_nd_dyn_ref<int, dyn, 3>)
+               == sizeof(int*) + sizeof(size_t));
+    static_assert(array_nd_dyn_ref<int, dyn, 3, dyn>::rank == 3);
+    static_assert(array_nd_dyn_ref<int, dyn, 3, dyn>::rank_dynamic == 2);
+}
+// indexing, mixed extents
+{
+    size_t rows = 5;
+    std::vector<int> v(rows * 4 * 3);
+    auto g = array_nd_dyn_ref<int, dyn, 4, dyn>{v.data(), rows, 3};
+    assert(g.size() == 5 && g.extent(1) == 4 && g.extent(2) == 3);
+    assert(g.stride(0) == 12 && g.stride(1) == 3 && g.stride(2) == 1);
+    assert(g.size_flat() == 60 && g.elements().size() == 60);
+
+    // (i) gives dyn sub view while the tail has dynamic extents
+    static_assert(std::is_same_v<decltype(g(0)),
+                                 array_nd_dyn_ref<int, 4, dyn>>);
+    g(2)(3)(1) = 7;
+    assert(v[2*12 + 3*3 + 1] == 7);
+    assert(g[2][3][1] == 7 && g.at(2)(3)[1] == 7);
+
+    // all-static tail gives array_nd_ref, and builtin ref via []
+    auto h = array_nd_dyn_ref<int, dyn, 4, 3>{v.data(), rows};
+    static_assert(std::is_same_v<decltype(h(0)), array_nd_ref<int[4][3]>>);
+    static_assert(std::is_same_v<decltype(h[0]), int(&)[4][3]>);
+    assert(h(2)(3)[1] == 7 && h[2][3][1] == 7);
+
+    bool thrown = false;
+    try { g.at(5); } catch (std::out_of_range&) { thrown = true; }
+    assert(thrown);
+}
+// fill, deep copy, comparisons
+{
+    int a[2][3]{{1,2,3},{4,5,6}};
+    std::vector<int> v(6);
+    auto d = array_nd_dyn_ref<int, dyn, dyn>{v.data(), 2, 3};
+    d = a;                              // deep copy from C-array
+    assert(v[5] == 6 && d == a);
+    d(1)(1) = 0;
+    assert(d != a && d < a);
+    d = array_nd_ref{a};                // deep copy from array_nd_ref
+    assert((d <=> a) == 0);
+
+    auto e = array_nd_dyn_ref<int, 2, dyn>{a};
+    assert(e == d && e.extent(1) == 3);
+    d.fill(9);
+    assert(v[0] == 9 && v[5] == 9 && d > e);
+    d.assign(e);
+    assert(d == e);
+
+    std::vector<int> w(6);
+    auto f = array_nd_dyn_ref<int, dyn, dyn>{w.data(), 3, 2}; // other shape
+    assert(f != d && (f <=> d) > 0);
+    bool thrown = false;
+    try { f.assign(d); } catch (std::length_error&) { thrown = true; }
+    assert(thrown);
+}
+// constexpr over flat storage
+{
+    static constexpr int buf[6]{1,2,3,4,5,6};
+    constexpr auto c = array_nd_dyn_ref<int const, dyn, 3>{buf, 2};
+    static_assert(c.size_flat() == 6 && c.elements()[4] == 5);
+    constexpr int x = []{
+        int b[6]{};
+        array_nd_dyn_ref<int, dyn, dyn>{b, 2, 3}.fill(2);
+        return b[5];
+    }();
+    static_assert(x == 2);
+}
+}
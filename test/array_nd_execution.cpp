@@ -0,0 +1,50 @@
+#include <cassert>
+#include <string>
+
+#include "array_nd_execution.hpp"
+
+using std::execution::par;
+using std::execution::par_unseq;
+using std::execution::seq;
+
+int main()
+{
+// large arrays split into chunks
+{
+    using A = double[64][128][256];   // 16 MiB, 16 chunks
+    static A a, b;
+    auto ar = array_nd_ref{a};
+    auto br = array_nd_ref{b};
+
+    array_nd::fill(par, ar, 0.0);
+    assert(a[63][127][255] == 0.0);
+    array_nd::fill(par_unseq, ar, 1.5);
+    assert(a[0][0][0] == 1.5 && a[31][64][128] == 1.5 && a[63][127][255] == 1.5);
+
+    array_nd::copy(par, ar, br);
+    assert(br == a && array_nd::equal(par, ar, br));
+
+    b[40][3][7] = -1;
+    assert(!array_nd::equal(par, ar, br) && !array_nd::equal(seq, br, a));
+
+    array_nd::swap(par, ar, b);
+    assert(a[40][3][7] == -1 && b[40][3][7] == 1.5);
+    assert(array_nd::equal(par, br, array_nd_ref<A const>{b}));
+
+    static int const c[1][1 << 21]{};    // outer extent 1: single chunk
+    static int d[1][1 << 21];
+    array_nd::fill(par, array_nd_ref{d}, 3);
+    array_nd::copy(par, c, array_nd_ref{d});
+    assert(array_nd::equal(par, array_nd_ref{d}, c));
+}
+// small and non-trivial arrays, single chunk
+{
+    std::string s[2][2]{{"a","b"},{"c","d"}};
+    std::string t[2][2];
+    array_nd::copy(par, s, array_nd_ref{t});
+    assert(array_nd::equal(par, array_nd_ref{t}, s));
+    array_nd::fill(par, array_nd_ref{t}, "x");
+    array_nd::swap(par, array_nd_ref{t}, s);
+    assert(s[1][1] == "x" && t[1][1] == "d");
+}
+}
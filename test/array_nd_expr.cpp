@@ -0,0 +1,115 @@
+#include <cassert>
+#include <numeric>
+
+#include "array_nd_expr.hpp"
+
+constexpr int fused()
+{
+    int a[2][3] {{1,2,3},{4,5,6}};
+    int b[2][3] {{6,5,4},{3,2,1}};
+    int c[2][3] {};
+    array_nd_ref{c} = array_nd_ref{a} + array_nd_ref{b} * 2 - 1;
+    array_nd_ref{c} = -(array_nd_ref{c} / 2);
+    return c[0][0] * 10 + c[1][2];
+}
+static_assert(fused() == -60 - 3);
+
+// nodes find their operators by ADL, here past operators that hide them
+namespace user
+{
+struct other {};
+other operator+(other, other);
+other operator-(other);
+other operator*(other, other);
+
+constexpr float compound()
+{
+    float x[2][3] {{1,2,3},{4,5,6}}, y[2][3] {{1,1,1},{1,1,1}}, z[2][3] {};
+    array_nd_ref{z} = (array_nd_ref{x} + y) * 2.f;
+    float const a = z[1][2];
+    array_nd_ref{z} = -(2.f * array_nd_ref{x});
+    float const b = z[0][1];
+    array_nd_ref{z} = (-array_nd_ref{x}) * (-array_nd_ref{x}) - y;
+    return a * 100 + b * 10 + z[1][1];
+}
+static_assert(compound() == 1400 - 40 + 24);
+}
+
+// one operand must be a ref or expression
+template <typename X, typename Y>
+concept bool addable = requires (X x, Y y) { x + y; };
+static_assert(addable<array_nd_ref<int[2][3]>, int>);
+static_assert(addable<int(&)[2][3], array_nd_ref<int[2][3]>>);
+static_assert(std::is_same_v<
+    decltype(array_nd_ref<int[4]>{nullptr} * 0.5)::array_type, double[4]>);
+
+// broadcast shapes, NumPy rules
+using impl::expr_shape_t, impl::expr_leaf;
+static_assert(std::is_same_v<expr_shape_t<expr_leaf<int[4][3]>,
+                                          expr_leaf<int[3]>, int>, int[4][3]>);
+static_assert(std::is_same_v<expr_shape_t<expr_leaf<int[4][1]>,
+                                          expr_leaf<int[3]>, int>, int[4][3]>);
+static_assert(std::is_same_v<expr_shape_t<expr_leaf<int[2][1][3]>,
+                                          expr_leaf<int[5][1]>, int>,
+                             int[2][5][3]>);
+
+constexpr int broadcast()
+{
+    int m[2][3] {{1,2,3},{4,5,6}};
+    int row[3] {10,20,30};
+    int col[2][1] {{100},{200}};
+    int c[2][3] {};
+    array_nd_ref{c} = array_nd_ref{m} + row + col;
+    return c[1][2];
+}
+static_assert(broadcast() == 236);
+
+int main()
+{
+    static float a[64][65], b[64][65], c[64][65];
+    auto ae = array_nd_ref{a}.elements();
+    auto be = array_nd_ref{b}.elements();
+    std::iota(ae.begin(), ae.end(), 0.f);
+    std::iota(be.begin(), be.end(), 1.f);
+
+    auto e = array_nd_ref{a} + array_nd_ref{b} * 2.f;
+    array_nd_ref{c} = e;                      // evaluated on assignment
+    for (size_t i = 0; i != 64; ++i)
+        for (size_t j = 0; j != 65; ++j)
+            assert(c[i][j] == a[i][j] + b[i][j] * 2.f);
+
+    // destination may alias an operand exactly
+    array_nd_ref{a} = array_nd_ref{a} - b;
+    for (float v : array_nd_ref{a}.elements())
+        assert(v == -1.f);
+
+    // int operands, double scalar: converted on assignment
+    int n[3] {1, 2, 3};
+    int m[3];
+    array_nd_ref{m} = array_nd_ref{n} * 1.5;
+    assert(m[0] == 1 && m[1] == 3 && m[2] == 4);
+
+    // rank 1 window into a const array
+    const int k[4] {4, 8, 12, 16};
+    array_nd_ref{m} = array_nd_ref<const int[3]>{k + 1} / 4 + n;
+    assert(m[0] == 3 && m[1] == 5 && m[2] == 7);
+
+    // bias row added to every row, column scale, outer product
+    static float x[33][17], bias[17], scale[33][1], y[33][17];
+    std::iota(bias, bias+17, 1.f);
+    for (size_t i = 0; i != 33; ++i)
+        scale[i][0] = float(i);
+    array_nd_ref{y} = array_nd_ref{bias} * 0.5f;      // broadcast assign
+    for (size_t i = 0; i != 33; ++i)
+        for (size_t j = 0; j != 17; ++j)
+            assert(y[i][j] == bias[j] * 0.5f);
+    array_nd_ref{x} = array_nd_ref{y} + bias;
+    array_nd_ref{x} = array_nd_ref{x} * scale - 1.f;
+    for (size_t i = 0; i != 33; ++i)
+        for (size_t j = 0; j != 17; ++j)
+            assert(x[i][j] == (bias[j] * 1.5f) * float(i) - 1.f);
+    array_nd_ref{y} = array_nd_ref{scale} * bias;
+    for (size_t i = 0; i != 33; ++i)
+        for (size_t j = 0; j != 17; ++j)
+            assert(y[i][j] == float(i) * bias[j]);
+}
@@ -0,0 +1,101 @@
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "array_nd_hash.hpp"
+
+using std::execution::par;
+
+// check values, iSCSI (RFC 3720) and xxHash
+constexpr char digits[9] {'1','2','3','4','5','6','7','8','9'};
+static_assert(array_nd::crc32c(digits) == 0xe3069283);
+
+constexpr unsigned char ascending[32] {0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,
+                      16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31};
+constexpr unsigned char zeros[4][8] {}, ones[2][16] {
+    {255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255},
+    {255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255}};
+static_assert(array_nd::crc32c(ascending) == 0x46dd794e);
+static_assert(array_nd::crc32c(zeros) == 0x8a9136aa);
+static_assert(array_nd::crc32c(array_nd_ref{ones}) == 0x62a8ab43);
+
+constexpr char abc[3] {'a','b','c'};
+static_assert(array_nd::xxhash64(abc) == 0x44bc2cf5ad770999);
+
+// the byte image: native order multibyte elements
+constexpr char nine[1] {'9'}, twelve[2] {'1','2'}, rest[7] {'3','4','5','6',
+                                                            '7','8','9'};
+constexpr uint16_t words[2][2] {{0x3231, 0x3433}, {0x3635, 0x3837}};
+constexpr char nine_digits[9] {'9','1','2','3','4','5','6','7','8'};
+static_assert(std::endian::native != std::endian::little
+           || array_nd::crc32c(words, array_nd::crc32c(nine))
+           == array_nd::crc32c(nine_digits));
+
+static_assert(array_nd::crc32c_combine(array_nd::crc32c(twelve),
+                                       array_nd::crc32c(rest), 7)
+              == 0xe3069283);
+
+// the span overloads accept the on_chunk bytes of "array_nd_io.hpp"
+static_assert(std::is_invocable_r_v<uint32_t,
+                  decltype([](std::span<std::byte const> b, uint32_t c) {
+                      return array_nd::crc32c(b, c);
+                  }), std::span<std::byte const>, uint32_t>);
+
+template <typename T>
+constexpr bool hashable = requires (T const& x) { array_nd::crc32c(x); };
+static_assert(hashable<float[2][3]> && hashable<array_nd_ref<int[4]>>);
+static_assert(!hashable<int*> && !hashable<std::vector<int>>);
+
+int main()
+{
+    assert(array_nd::xxhash64(std::span<std::byte const>{})
+           == 0xef46db3751d8e999);
+
+    // longer input, all stripes and tails, against the reference
+    static unsigned char data[1000];
+    for (size_t i = 0; i != sizeof data; ++i)
+        data[i] = (unsigned char)((i * 37 + 11) % 256);
+    assert(array_nd::xxhash64(data) == 0x128da10cfbdc59d9);
+    assert(array_nd::xxhash64(array_nd_ref{data}, 0x9e3779b97f4a7c15)
+           == 0x70d9b29663777bf9);
+    auto const bytes = std::as_bytes(std::span{data});
+    assert(array_nd::xxhash64(bytes.first(45), 7) == 0xdf37f0c15380bcdc);
+    assert(array_nd::crc32c(digits) == 0xe3069283);
+
+    // the dispatched CRC agrees with the portable one, at all lengths
+    // and alignments up to several interleaved blocks
+    static unsigned char big[3 * 3 * 8192 + 100];
+    for (size_t i = 0; i != sizeof big; ++i)
+        big[i] = (unsigned char)(i * 2654435761u >> 13);
+    for (size_t off : {0, 1, 5})
+        for (size_t n : {0, 1, 7, 8, 63, 4096, 24575, 24576, 24577,
+                         3*24576 + 99 - 5})
+        {
+            auto const b = std::as_bytes(std::span{big + off, n});
+            uint32_t const c = array_nd::crc32c(b, 0x1234);
+            assert(c == ~impl::crc32c_portable(~0x1234u, big + off, n));
+            // a split continues the CRC, and its parts combine
+            auto const [h, t] = std::pair{b.first(n / 3), b.subspan(n / 3)};
+            assert(array_nd::crc32c(t, array_nd::crc32c(h, 0x1234)) == c);
+            assert(array_nd::crc32c_combine(array_nd::crc32c(h, 0x1234),
+                                            array_nd::crc32c(t), t.size())
+                   == c);
+        }
+
+    // snapshot-sized, in parallel chunks
+    static float snap[64][256][256];
+    float* f = impl::flat(snap);
+    for (size_t i = 0; i != array_size<decltype(snap)>; ++i)
+        f[i] = float(i % 1021) * 0.5f;
+    uint32_t const s = array_nd::crc32c(snap);
+    assert(array_nd::crc32c(par, snap) == s);
+    assert(array_nd::crc32c(par, array_nd_ref{snap}, 77)
+           == array_nd::crc32c(snap, 77));
+    assert(array_nd::crc32c(std::execution::seq, snap) == s);
+    snap[40][1][2] = 1e9f;
+    assert(array_nd::crc32c(par, snap) != s);
+
+    static float small[3][5];
+    assert(array_nd::crc32c(par, small) == array_nd::crc32c(small));
+}
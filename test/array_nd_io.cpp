@@ -0,0 +1,84 @@
+#include <cassert>
+#include <cstdint>
+#include <filesystem>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "array_nd_io.hpp"
+
+using array_nd::io_options;
+
+int main()
+{
+    auto const path = std::filesystem::temp_directory_path()
+                    / "array_nd_io.bin";
+    int const fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+    assert(fd >= 0);
+
+    // chunks of whole outer subarrays, on_chunk once per chunk, in order
+    static uint32_t x[100][1000], y[100][1000];
+    auto e = array_nd_ref{x}.elements();
+    std::iota(e.begin(), e.end(), 0u);
+
+    std::vector<size_t> at;
+    size_t bytes = 0;
+    array_nd::write_to(fd, x, {.chunk_bytes = 40000},
+        [&](std::span<std::byte const> c, size_t o) {
+            at.push_back(o);
+            bytes += c.size();
+        });
+    assert(bytes == sizeof x && at.size() == 10 && at[9] == 360000);
+    assert(::lseek(fd, 0, SEEK_CUR) == off_t(sizeof x));
+
+    ::lseek(fd, 0, SEEK_SET);
+    array_nd::read_into(array_nd_ref{y}, fd, {.chunk_bytes = 65536});
+    assert(array_nd_ref{y} == x);
+
+    // byte-swapped file, tail chunk of part of the chunk size
+    ::lseek(fd, 0, SEEK_SET);
+    array_nd::write_to(fd, array_nd_ref{x}, {.chunk_bytes = 12345 * 4,
+                                             .order = std::endian::big});
+    uint32_t be[2];
+    assert(::pread(fd, be, sizeof be, 4) == sizeof be);
+    assert(be[0] == 0x01000000 && be[1] == 0x02000000);
+    ::lseek(fd, 0, SEEK_SET);
+    array_nd::read_into(array_nd_ref{y}, fd, {.order = std::endian::big});
+    assert(array_nd_ref{y} == x);
+    assert(e[99999] == 99999);     // source is unchanged
+
+    // direct I/O, used where the file system supports it
+    static double d[3][1000], r[3][1000];
+    std::iota(&d[0][0], &d[0][0] + 3000, 0.5);
+    ::lseek(fd, 0, SEEK_SET);
+    array_nd::write_to(fd, d, {.chunk_bytes = 8192, .direct = true});
+    ::lseek(fd, 0, SEEK_SET);
+    size_t chunks = 0;
+    array_nd::read_into(array_nd_ref{r}, fd, {.chunk_bytes = 8192,
+                                              .direct = true},
+        [&](std::span<std::byte const>, size_t) { ++chunks; });
+    assert(array_nd_ref{r} == d && chunks == 3);
+
+    // end of file throws
+    ::ftruncate(fd, 1000);
+    ::lseek(fd, 0, SEEK_SET);
+    bool eof = false;
+    try { array_nd::read_into(array_nd_ref{y}, fd); }
+    catch (std::runtime_error const&) { eof = true; }
+    assert(eof);
+    ::close(fd);
+    std::filesystem::remove(path);
+
+    // through a pipe, writer and reader on two threads
+    int p[2];
+    assert(::pipe(p) == 0);
+    static uint32_t z[100][1000];
+    std::thread w([&] {
+        array_nd::write_to(p[1], x, {.chunk_bytes = 1 << 16});
+        ::close(p[1]);
+    });
+    array_nd::read_into(array_nd_ref{z}, p[0], {.chunk_bytes = 1 << 15});
+    w.join();
+    ::close(p[0]);
+    assert(array_nd_ref{z} == x);
+}
@@ -0,0 +1,112 @@
+#include <cassert>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "array_nd_layout.hpp"
+
+using array_nd::row_major;
+using array_nd::column_major;
+using array_nd::tiled;
+using array_nd::morton;
+
+template <typename A, typename L>
+using lref = array_nd_layout_ref<A, L>;
+
+// a row-major layout ref views only storage of its extents and element
+static_assert(std::is_constructible_v<lref<int const[2][3], row_major>,
+                                      array_nd_ref<int[2][3]>>);
+static_assert(!std::is_constructible_v<lref<float[64][64], row_major>,
+                                       array_nd_ref<float[2][2]>>);
+static_assert(!std::is_constructible_v<lref<int[2][3], row_major>,
+                                       array_nd_ref<int[3][2]>>);
+static_assert(!std::is_constructible_v<lref<int[2][3], row_major>,
+                                       array_nd_ref<int const[2][3]>>);
+static_assert(!std::is_constructible_v<lref<int[2][3], row_major>,
+                                       array_nd_ref<unsigned[2][3]>>);
+
+int main()
+{
+// mappings
+{
+    using C = column_major::mapping<int[2][3][4]>;
+    static_assert(C::offset({1,0,0}) == 1 && C::offset({0,1,0}) == 2
+               && C::offset({0,0,1}) == 6 && C::offset({1,2,3}) == 23);
+
+    using T = tiled<2,4>::mapping<int[5][10]>;      // padded to 6 x 12
+    static_assert(T::required_span_size == 3*3*8);
+    static_assert(T::offset({0,4}) == 8 && T::offset({1,5}) == 13
+               && T::offset({2,0}) == 24 && T::offset({4,9}) == 2*24+2*8+1);
+
+    using Z = morton::mapping<int[4][4]>;
+    static_assert(Z::offset({0,1}) == 1 && Z::offset({1,0}) == 2
+               && Z::offset({1,1}) == 3 && Z::offset({0,2}) == 4
+               && Z::offset({3,3}) == 15);
+    using Zw = morton::mapping<int[2][8]>;          // wide: j high bits
+    static_assert(Zw::offset({1,1}) == 3 && Zw::offset({0,2}) == 4
+               && Zw::offset({1,7}) == 15);
+}
+// for_each visits every element once in storage order, any layout
+{
+    auto check = [](auto m) {
+        using M = decltype(m);
+        std::vector<int> seen(M::required_span_size);
+        size_t last = 0, n = 0;
+        bool ordered = true;
+        M::for_each([&](size_t off, auto const& ix) {
+            ordered = ordered && (n == 0 || off > last);
+            ordered = ordered && off == M::offset(ix);
+            last = off; ++n;
+            ++seen[off];
+        });
+        return ordered && n == array_size<typename M::array_type>
+            && std::count(seen.begin(), seen.end(), 1) == long(n);
+    };
+    assert(check(row_major::mapping<int[3][4][5]>{}));
+    assert(check(column_major::mapping<int[3][4][5]>{}));
+    assert(check(tiled<4,4>::mapping<int[7][9]>{}));
+    assert(check(morton::mapping<int[8][32]>{}));
+}
+// copy between layouts and logical compare
+{
+    static int a[16][32];
+    auto e = array_nd_ref{a}.elements();
+    std::iota(e.begin(), e.end(), 0);
+
+    using A = int[16][32];
+    static int col[16*32];
+    static int til[lref<A, tiled<4,8>>::required_span_size];
+    static int zed[16*32];
+    lref<A, column_major> c{col};
+    lref<A, tiled<4,8>> t{til};
+    lref<A, morton> z{zed};
+
+    c.assign(array_nd_ref{a});          // blocked row -> column
+    t.assign(c);
+    z.assign(t);
+    assert(c(3,5) == a[3][5] && t(15,31) == a[15][31] && z(9,17) == a[9][17]);
+    assert(col[1] == a[1][0] && zed[3] == a[1][1] && til[8] == a[1][0] && til[32] == a[0][8]);
+    assert((c == z && t == c && z == lref<A, row_major>{array_nd_ref{a}}));
+
+    static int back[16][32];
+    lref<A, row_major> r{array_nd_ref{back}};
+    r.assign(z);
+    assert(array_nd_ref{back} == a);
+
+    z(0,0) = -1;
+    assert(!(z == c) && c == t);
+    t.fill(7);
+    assert(t(15,31) == 7);
+}
+// constexpr over flat storage
+{
+    constexpr int v = []{
+        int s[4*4]{};
+        int d[4*4]{};
+        for (int i = 0; i != 16; ++i) s[i] = i;
+        lref<int[4][4], morton>{d}.assign(lref<int[4][4], row_major>{s});
+        return d[3] * 100 + lref<int[4][4], morton>{d}(2,3);
+    }();
+    static_assert(v == 5*100 + 11);
+}
+}
@@ -0,0 +1,62 @@
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+#include "array_nd_matmul.hpp"
+
+constexpr int product()
+{
+    const int a[2][3] {{1,2,3},{4,5,6}};
+    const int b[3][2] {{7,8},{9,10},{11,12}};
+    int c[2][2] {};
+    array_nd::matmul(array_nd_ref{c}, array_nd_ref{a}, array_nd_ref{b});
+    return c[0][0] * 1000 + c[1][1];
+}
+static_assert(product() == 58 * 1000 + 154);
+
+// shapes are constraints
+template <typename C, typename A, typename B>
+concept bool multipliable = requires (C c, A a, B b) {
+    array_nd::matmul(c, a, b);
+};
+static_assert(multipliable<array_nd_ref<int[2][4]>, array_nd_ref<int[2][3]>,
+                           array_nd_ref<int const[3][4]>>);
+static_assert(!multipliable<array_nd_ref<int[2][4]>, array_nd_ref<int[2][3]>,
+                            array_nd_ref<int[4][4]>>);
+static_assert(!multipliable<array_nd_ref<int[2][5]>, array_nd_ref<int[2][3]>,
+                            array_nd_ref<int[3][4]>>);
+
+// check<T,M,K,N> against a plain triple loop, in double
+template <typename T, size_t M, size_t K, size_t N>
+void check()
+{
+    static T a[M][K], b[K][N], c[M][N];
+    for (size_t i = 0; i != M; ++i)
+        for (size_t k = 0; k != K; ++k)
+            a[i][k] = T((i * 7 + k * 3) % 11) - T(5);
+    for (size_t k = 0; k != K; ++k)
+        for (size_t j = 0; j != N; ++j)
+            b[k][j] = T((k * 5 + j) % 13) - T(6);
+
+    array_nd::matmul(array_nd_ref{c}, array_nd_ref{a}, array_nd_ref{b});
+
+    for (size_t i = 0; i != M; ++i)
+        for (size_t j = 0; j != N; ++j)
+        {
+            double s = 0;
+            for (size_t k = 0; k != K; ++k)
+                s += double(a[i][k]) * double(b[k][j]);
+            assert(std::abs(double(c[i][j]) - s) <= 1e-6 * (1 + std::abs(s)));
+        }
+}
+
+int main()
+{
+    check<float, 3, 5, 7>();
+    check<float, 64, 64, 64>();
+    check<float, 97, 300, 45>();       // edge tiles, two KC blocks
+    check<double, 64, 64, 64>();
+    check<double, 131, 67, 259>();
+    check<int32_t, 50, 70, 90>();
+    check<int64_t, 33, 33, 33>();
+}
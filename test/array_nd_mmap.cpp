@@ -0,0 +1,86 @@
+#include <cassert>
+#include <cstdint>
+#include <numeric>
+
+#include "array_nd_mmap.hpp"
+
+using array_nd::file_layout;
+using array_nd::mapped_array;
+
+static_assert(!std::is_copy_constructible_v<mapped_array<int[4]>>);
+static_assert(std::is_same_v<
+    decltype(std::declval<mapped_array<int const[2][3]>>().ref()),
+    array_nd_ref<int const[2][3]>>);
+
+// create(path) is for writable arrays only
+template <typename A>
+concept bool creatable = requires { mapped_array<A>::create(""); };
+static_assert(creatable<int[4]> && !creatable<int const[4]>);
+
+template <typename E>
+bool throws(auto f)
+{
+    try { f(); } catch (E const&) { return true; }
+    return false;
+}
+
+int main()
+{
+    auto const dir = std::filesystem::temp_directory_path();
+    auto const raw = dir / "array_nd_mmap_raw.bin";
+    auto const hdr = dir / "array_nd_mmap_hdr.bin";
+
+    using grid = float[64][100];
+    {
+        auto m = mapped_array<grid>::create(raw);
+        auto e = m.ref().elements();
+        assert(e[0] == 0.f && e[6399] == 0.f);
+        std::iota(e.begin(), e.end(), 0.f);
+        m.sync();
+
+        auto h = mapped_array<grid>::create(hdr, file_layout::header);
+        h.ref() = m.data();
+        h.sync(false);
+    }
+    assert(std::filesystem::file_size(raw) == sizeof(grid));
+    assert(std::filesystem::file_size(hdr) == 256 + sizeof(grid));
+    {
+        auto r = mapped_array<grid const>::open(raw);
+        r.advise(MADV_WILLNEED);
+        array_nd_ref<grid const> g = r;
+        assert(g[63][99] == 6399.f && r.data()[1][2] == 102.f);
+
+        auto h = mapped_array<grid const>::open(hdr, file_layout::header);
+        assert(h.ref() == r.ref());
+
+        // moves transfer the mapping
+        auto h2 = std::move(h);
+        assert(h2.data()[5][5] == 505.f);
+    }
+    // write through a read-write mapping of an existing file
+    {
+        auto w = mapped_array<grid>::open(raw);
+        w.data()[0][0] = -1.f;
+    }
+    assert(mapped_array<grid const>::open(raw).data()[0][0] == -1.f);
+
+    // shape, type and size checks
+    assert(throws<std::runtime_error>([&]{
+        mapped_array<float const[100][64]>::open(hdr, file_layout::header);
+    }));
+    assert(throws<std::runtime_error>([&]{
+        mapped_array<int32_t const[64][100]>::open(hdr, file_layout::header);
+    }));
+    assert(throws<std::runtime_error>([&]{
+        mapped_array<grid const>::open(raw, file_layout::header);
+    }));
+    assert(throws<std::runtime_error>([&]{
+        mapped_array<float const[64][99]>::open(raw);
+    }));
+    assert(throws<std::system_error>([&]{
+        mapped_array<grid const>::open(dir / "array_nd_mmap_none.bin");
+    }));
+
+    std::filesystem::remove(raw);
+    std::filesystem::remove(hdr);
+}
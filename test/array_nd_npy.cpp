@@ -0,0 +1,150 @@
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+
+#include "array_nd_mmap.hpp"
+#include "array_nd_npy.hpp"
+
+using array_nd::file_layout;
+using array_nd::mapped_array;
+
+template <typename E>
+bool throws(auto f)
+{
+    try { f(); } catch (E const&) { return true; }
+    return false;
+}
+
+std::string slurp(std::filesystem::path const& p)
+{
+    std::ifstream f(p, std::ios::binary);
+    std::stringstream s;
+    s << f.rdbuf();
+    return s.str();
+}
+
+struct rgb { uint8_t r, g, b; };
+
+int main()
+{
+    auto const dir = std::filesystem::temp_directory_path();
+    auto const path = dir / "array_nd_npy.npy";
+
+    // header as np.save writes it, payload at 64-byte alignment
+    float x[2][3] {{1,2,3},{4,5,6}};
+    array_nd::write_npy(path, x);
+    std::string const f = slurp(path);
+    std::string const dict =
+        "{'descr': '<f4', 'fortran_order': False, 'shape': (2, 3), }";
+    assert(f.size() == 128 + sizeof x);
+    assert(f.compare(0, 10, "\x93NUMPY\x01\x00v\x00", 10) == 0);
+    assert(f.compare(10, dict.size(), dict) == 0);
+    assert(f[127] == '\n' && f[126] == ' ');
+    assert(std::memcmp(f.data() + 128, x, sizeof x) == 0);
+
+    assert(impl::npy_header<int64_t[7]>().find("'<i8'") != std::string::npos);
+    assert(impl::npy_header<int64_t[7]>().find("(7,)") != std::string::npos);
+    assert(impl::npy_header<bool[1][2][3]>().find("'|b1'") != std::string::npos);
+    assert(impl::npy_header<rgb[4]>().find("'|V3'") != std::string::npos);
+
+    // streaming read, and zero-copy map
+    float y[2][3] {};
+    array_nd::read_npy(path, array_nd_ref{y});
+    assert(array_nd_ref{y} == x);
+    array_nd::write_npy(path, array_nd_ref{y});
+    assert(slurp(path) == f);
+    {
+        auto m = mapped_array<float const[2][3]>::open(path, file_layout::npy);
+        assert(m.ref() == x);
+    }
+
+    // dtype and shape mismatches
+    assert(throws<std::runtime_error>([&]{
+        int32_t z[2][3];
+        array_nd::read_npy(path, array_nd_ref{z});
+    }));
+    assert(throws<std::runtime_error>([&]{
+        double z[2][3];
+        array_nd::read_npy(path, array_nd_ref{z});
+    }));
+    assert(throws<std::runtime_error>([&]{
+        float z[3][2];
+        array_nd::read_npy(path, array_nd_ref{z});
+    }));
+    assert(throws<std::runtime_error>([&]{
+        float z[6];
+        array_nd::read_npy(path, array_nd_ref{z});
+    }));
+    assert(throws<std::runtime_error>([&]{
+        mapped_array<float const[2][3][1]>::open(path, file_layout::npy);
+    }));
+
+    // create a .npy mapping, write through it, read it back
+    {
+        auto m = mapped_array<uint16_t[40][50]>::create(path, file_layout::npy);
+        auto e = m.ref().elements();
+        std::iota(e.begin(), e.end(), uint16_t{0});
+    }
+    static uint16_t u[40][50];
+    array_nd::read_npy(path, array_nd_ref{u});
+    assert(u[39][49] == 1999);
+    assert(slurp(path).find("(40, 50)") != std::string::npos);
+
+    // version 2.0 header, other key order and spacing, as other writers may
+    {
+        std::string d = "{\"shape\":(3,),\"fortran_order\":False,\"descr\":\"<i4\"}";
+        d.append(63 - (12 + d.size()) % 64, ' ');
+        d += '\n';
+        std::string h("\x93NUMPY\x02\x00", 8);
+        for (size_t b = 0; b != 4; ++b)
+            h += char(d.size() >> 8*b);
+        int32_t const v[3] {7, 8, 9};
+        std::ofstream(path, std::ios::binary)
+            << h << d << std::string_view((char const*)v, sizeof v);
+        int32_t w[3] {};
+        array_nd::read_npy(path, array_nd_ref{w});
+        assert(w[0] == 7 && w[2] == 9);
+    }
+    // fortran order is not accepted
+    {
+        std::string h = impl::npy_header<int32_t[3]>();
+        h.replace(h.find("False"), 5, "True ");
+        std::ofstream(path, std::ios::binary) << h << std::string(12, '\0');
+        assert(throws<std::runtime_error>([&]{
+            int32_t w[3];
+            array_nd::read_npy(path, array_nd_ref{w});
+        }));
+    }
+    // a header padded to 4 bytes leaves doubles misaligned for mapping
+    {
+        std::string d = "{'descr': '<f8', 'fortran_order': False, "
+                        "'shape': (3,), }";
+        while ((10 + d.size() + 1) % 8 != 4)
+            d += ' ';
+        d += '\n';
+        std::string h("\x93NUMPY\x01\x00", 8);
+        h += char(d.size());
+        h += char(d.size() >> 8);
+        assert((h.size() + d.size()) % 8 == 4);
+        double const v[3] {1, 2, 3};
+        std::ofstream(path, std::ios::binary)
+            << h << d << std::string_view((char const*)v, sizeof v);
+        double w[3] {};
+        array_nd::read_npy(path, array_nd_ref{w});
+        assert(w[2] == 3);
+        assert(throws<std::runtime_error>([&]{
+            mapped_array<double const[3]>::open(path, file_layout::npy);
+        }));
+    }
+    // truncated or malformed header dicts throw, reading no further
+    for (std::string_view d : {"{'descr': ", "{'descr': '<f4", "{'descr'",
+                               "{'descr': '<f4', 'fortran_order': False, "
+                               "'shape': (2, 3", "{'descr': ,}",
+                               "{'descr': '<f4', 'fortran_order': False"})
+        assert(throws<std::runtime_error>([&]{
+            impl::check_npy_header<float[2][3]>(d);
+        }));
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,94 @@
+#include <cassert>
+#include <numeric>
+
+#include "array_nd_permute.hpp"
+
+using array_nd::permute;
+
+static_assert(std::is_same_v<
+    decltype(permute<2,0,1>(array_nd_ref<int[2][3][4]>{nullptr}))::array_type,
+    int[4][2][3]>);
+
+// Axes... must be a permutation of 0...rank-1
+template <typename A, size_t... Axes>
+concept bool permutable = requires (array_nd_ref<A> x) {
+    permute<Axes...>(x);
+};
+static_assert(permutable<int[2][3], 1, 0>);
+static_assert(!permutable<int[2][3], 1, 1>);
+static_assert(!permutable<int[2][3], 0, 2>);
+static_assert(!permutable<int[2][3][4], 1, 0>);
+
+constexpr int view()
+{
+    int a[2][3][4] {};
+    int n = 0;
+    for (auto& x : array_nd_ref{a}.elements())
+        x = n++;
+    auto v = permute<2,0,1>(array_nd_ref{a});
+    v(3,1,2) = -1;
+    return a[1][2][3] * 100 + v(1,0,2);
+}
+static_assert(view() == -100 + 9);
+
+constexpr int assign()
+{
+    int a[2][3] {{1,2,3},{4,5,6}};
+    int t[3][2] {};
+    array_nd_ref{t} = permute<1,0>(array_nd_ref{a});
+    return t[0][1] * 10 + t[2][0];
+}
+static_assert(assign() == 43);
+
+// a different element type converts, element-wise
+constexpr double assign_convert()
+{
+    int a[2][3] {{1,2,3},{4,5,6}};
+    double t[3][2] {};
+    array_nd_ref{t} = permute<1,0>(array_nd_ref{a});
+    return t[0][1] * 10 + t[2][0];
+}
+static_assert(assign_convert() == 43);
+
+int main()
+{
+    static float x[6][33][70], y[70][6][33], z[33][6][70];
+    auto xe = array_nd_ref{x}.elements();
+    std::iota(xe.begin(), xe.end(), 0.f);
+
+    // innermost axis moved: strided transposes of 2D slices
+    array_nd_ref{y} = permute<2,0,1>(array_nd_ref{x});
+    for (size_t i = 0; i != 6; ++i)
+        for (size_t j = 0; j != 33; ++j)
+            for (size_t k = 0; k != 70; ++k)
+                assert(y[k][i][j] == x[i][j][k]);
+
+    // innermost axis kept: row copies
+    array_nd_ref{z} = permute<1,0,2>(array_nd_ref{x});
+    for (size_t i = 0; i != 6; ++i)
+        for (size_t j = 0; j != 33; ++j)
+            for (size_t k = 0; k != 70; ++k)
+                assert(z[j][i][k] == x[i][j][k]);
+
+    // view as an expression operand
+    array_nd_ref{y} = permute<2,0,1>(array_nd_ref{x}) * 2.f + 1.f;
+    for (size_t i = 0; i != 6; ++i)
+        for (size_t j = 0; j != 33; ++j)
+            for (size_t k = 0; k != 70; ++k)
+                assert(y[k][i][j] == x[i][j][k] * 2.f + 1.f);
+
+    // const source
+    float const (&cx)[6][33][70] = x;
+    array_nd_ref{z} = permute<1,0,2>(array_nd_ref{cx});
+    assert(z[32][5][69] == x[5][32][69]);
+
+    // int to double, at a size that would take the blocked path
+    static int ix[33][70];
+    static double dy[70][33];
+    auto ie = array_nd_ref{ix}.elements();
+    std::iota(ie.begin(), ie.end(), 0);
+    array_nd_ref{dy} = permute<1,0>(array_nd_ref{ix});
+    for (size_t j = 0; j != 33; ++j)
+        for (size_t k = 0; k != 70; ++k)
+            assert(dy[k][j] == ix[j][k]);
+}
@@ -0,0 +1,153 @@
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+
+#include "array_nd_reduce.hpp"
+
+constexpr int ci[2][3] {{3,1,4},{1,5,9}};
+static_assert(array_nd::sum(ci) == 23);
+static_assert(array_nd::product(ci) == 540);
+static_assert(array_nd::min(ci) == 1 && array_nd::max(ci) == 9);
+static_assert(array_nd::minmax(ci) == std::pair{1,9});
+static_assert(array_nd::reduce(ci, 0, [](int a, int b){ return a|b; }) == 15);
+
+// along an axis, dst shape is x's less that axis
+static_assert(std::is_same_v<remove_axis_t<int[2][3][4],1>, int[2][4]>);
+static_assert(std::is_same_v<remove_axis_t<int const[2][3],0>, int const[3]>);
+
+template <size_t K, typename X, typename D>
+concept bool axis_sums = requires (X const& x, array_nd_ref<D> d) {
+    array_nd::sum_axis<K>(x, d);
+};
+static_assert(axis_sums<1, int[2][3][4], int[2][4]>);
+static_assert(!axis_sums<1, int[2][3][4], int[2][3]>);
+static_assert(!axis_sums<3, int[2][3][4], int[2][3][4]>);
+static_assert(!axis_sums<0, int[4], int[1]>);
+
+constexpr int axes()
+{
+    int s0[3]{}, s1[2]{}, m[2]{}, a0[3]{}, a1[2]{};
+    array_nd::sum_axis<0>(ci, array_nd_ref{s0});
+    array_nd::sum_axis<1>(ci, array_nd_ref{s1});
+    array_nd::max_axis<1>(ci, array_nd_ref{m});
+    array_nd::argmax_axis<0>(ci, array_nd_ref{a0});
+    array_nd::argmax_axis<1>(ci, array_nd_ref{a1});
+    return s0[0]*10000 + s0[2]*100 + s1[1]
+         + (m[0] + m[1] == 13) + (a0[0]==0 && a0[1]==1 && a0[2]==1)
+         + (a1[0]==2 && a1[1]==2);
+}
+static_assert(axes() == 41315 + 3);
+
+constexpr double mixed()
+{
+    float x[4][4] {{1,2,3,4},{8,7,6,5},{0,0,9,0},{1.5f,1,1,1}};
+    double m[4] {}, n[4] {};
+    array_nd::max_axis<1>(array_nd_ref{x}, array_nd_ref{m});
+    array_nd::max_axis<0>(x, array_nd_ref{n});
+    return m[0] + m[1] + m[2] + m[3] + n[0] + n[1] + n[2] + n[3];
+}
+static_assert(mixed() == 4 + 8 + 9 + 1.5 + 8 + 7 + 9 + 5);
+
+// axis_array<K,O,N,I> a float array of extent N on axis K, the others
+// O and I in order, e.g. float[O][I][N] for K == 2
+template <size_t K, size_t O, size_t N, size_t I>
+using axis_array = std::conditional_t<K == 0, float[N][O][I],
+                   std::conditional_t<K == 1, float[O][N][I],
+                                              float[O][I][N]>>;
+
+// check_axes<K,O,N,I>() runtime reductions over axis K, of extent N,
+// agree with naive loops
+template <size_t K, size_t O, size_t N, size_t I>
+void check_axes()
+{
+    static axis_array<K,O,N,I> x;
+    static double s[O][I], m[O][I];     // dst of another element type
+    static int a[O][I];
+    auto const at = [](size_t o, size_t n, size_t i) -> float& {
+        if constexpr (K == 0)
+            return x[n][o][i];
+        else if constexpr (K == 1)
+            return x[o][n][i];
+        else
+            return x[o][i][n];
+    };
+    for (size_t o = 0; o != O; ++o)
+        for (size_t n = 0; n != N; ++n)
+            for (size_t i = 0; i != I; ++i)
+                at(o,n,i) = float((o*7 + n*13 + i*29) % 64);
+
+    array_nd::sum_axis<K>(array_nd_ref{x}, array_nd_ref{s});
+    array_nd::max_axis<K>(x, array_nd_ref{m});
+    array_nd::argmax_axis<K>(x, array_nd_ref{a});
+    for (size_t o = 0; o != O; ++o)
+        for (size_t i = 0; i != I; ++i)
+        {
+            double t = 0;
+            size_t j = 0;
+            for (size_t n = 0; n != N; ++n)
+            {
+                t += at(o,n,i);
+                if (at(o,j,i) < at(o,n,i))
+                    j = n;
+            }
+            assert(s[o][i] == t);
+            assert(m[o][i] == at(o,j,i));
+            assert(a[o][i] == int(j));
+        }
+}
+
+// check(x) runtime results agree with serial folds, all lengths around lanes
+template <typename T, size_t N>
+void check()
+{
+    static T a[N][3];
+    T* p = &a[0][0];
+    for (size_t i = 0; i != N*3; ++i)
+        p[i] = T((i * 37) % 101) - T(50);
+
+    T s{}, lo = p[0], hi = p[0];
+    for (size_t i = 0; i != N*3; ++i)
+    {
+        s += p[i];
+        lo = std::min(lo, p[i]);
+        hi = std::max(hi, p[i]);
+    }
+    assert(array_nd::sum(a) == s);
+    assert(array_nd::sum(array_nd_ref{a}) == s);
+    assert(array_nd::min(a) == lo && array_nd::max(a) == hi);
+    assert(array_nd::minmax(array_nd_ref{a}) == std::pair(lo,hi));
+    assert(array_nd::sum(a, int64_t{7}) == int64_t(s) + 7);
+}
+
+int main()
+{
+    check<int, 1>();
+    check<int, 11>();
+    check<int, 21>();
+    check<int, 22>();
+    check<int, 1000>();
+    check<double, 5>();
+    check<double, 333>();
+    check<int64_t, 77>();
+
+    // float sum in double accumulator is exact here
+    static float f[256][256];
+    for (auto& v : array_nd_ref{f}.elements())
+        v = 0.5f;
+    assert(array_nd::sum(f) == 32768.f);
+    assert(array_nd::sum(f, 0.0) == 32768.0);
+
+    check_axes<1, 3, 5, 7>();
+    check_axes<1, 2, 9, 1>();
+    check_axes<1, 4, 100, 1>();
+    check_axes<1, 2, 3, 5000>();
+
+    // outermost and innermost axes
+    check_axes<0, 8, 4, 70>();
+    check_axes<2, 4, 70, 8>();
+
+    double d[3] {1.5, 2., 4.};
+    assert(array_nd::product(d) == 12.);
+    assert(array_nd::product(array_nd_ref{d}, 2.) == 24.);
+}
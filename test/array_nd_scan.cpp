@@ -0,0 +1,115 @@
+#include <cassert>
+#include <cstdint>
+
+#include "array_nd_scan.hpp"
+
+using std::execution::par;
+
+// compile-time tables
+constexpr auto triangular()
+{
+    struct { int t[2][8]; } r{};
+    int ones[2][8] {{1,1,1,1,1,1,1,1},{2,2,2,2,2,2,2,2}};
+    array_nd::inclusive_scan_axis<1>(ones, array_nd_ref{r.t});
+    array_nd::inclusive_scan_axis<0>(array_nd_ref{r.t}, array_nd_ref{r.t});
+    return r;
+}
+static_assert(triangular().t[0][7] == 8 && triangular().t[1][7] == 24);
+
+constexpr int exclusive()
+{
+    int x[2][3] {{1,2,3},{4,5,6}}, e[2][3] {};
+    array_nd::exclusive_scan_axis<0>(x, array_nd_ref{e}, 10);
+    array_nd::exclusive_scan_axis<1>(array_nd_ref{x}, array_nd_ref{x});
+    return e[0][2] * 1000 + e[1][2] * 10 + x[1][0] + x[1][2];
+}
+static_assert(exclusive() == 10000 + 130 + 9);
+
+constexpr int sat()
+{
+    int x[3][3] {{1,2,3},{4,5,6},{7,8,9}}, s[3][3] {};
+    array_nd::summed_area_table(x, array_nd_ref{s});
+    return s[1][1] * 100 + s[2][2];
+}
+static_assert(sat() == 1245);
+
+// scan_dst: dst of x's shape, any element type
+template <size_t K, typename X, typename D>
+concept bool scannable = requires (X const& x, array_nd_ref<D> d) {
+    array_nd::inclusive_scan_axis<K>(x, d);
+};
+static_assert(scannable<1, int[2][3], long[2][3]>);
+static_assert(!scannable<1, int[2][3], int[3][2]>);
+static_assert(!scannable<2, int[2][3], int[2][3]>);
+
+// check<K,X,D>() runtime scans of X into D along axis K agree with
+// serial loops over x viewed as [O][N][I], serial and parallel
+template <size_t K, typename X, typename D>
+void check()
+{
+    using T = std::remove_all_extents_t<X>;
+    using Acc = std::remove_all_extents_t<D>;
+    static X x;
+    static D in, ex, p;
+    constexpr size_t N = std::extent_v<X,K>, I = impl::strides<X>[K];
+    constexpr size_t O = array_size<X> / (N*I);
+    T* f = impl::flat(x);
+    for (size_t j = 0; j != O*N*I; ++j)
+        f[j] = T((j * 37) % 101);
+
+    auto xr = array_nd_ref{x};
+    array_nd::inclusive_scan_axis<K>(x, array_nd_ref{in});
+    array_nd::exclusive_scan_axis<K>(xr, array_nd_ref{ex}, Acc(5));
+    for (size_t o = 0; o != O; ++o)
+        for (size_t i = 0; i != I; ++i)
+        {
+            Acc a = 0;
+            for (size_t n = 0; n != N; ++n)
+            {
+                size_t const j = (o*N + n)*I + i;
+                assert(impl::flat(ex)[j] == Acc(a + 5));
+                a += f[j];
+                assert(impl::flat(in)[j] == a);
+            }
+        }
+    array_nd::inclusive_scan_axis<K>(par, x, array_nd_ref{p});
+    assert(array_nd_ref{p} == in);
+    array_nd::exclusive_scan_axis<K>(par, x, array_nd_ref{p}, Acc(5));
+    assert(array_nd_ref{p} == ex);
+}
+
+int main()
+{
+    // innermost axis, SIMD row scans with tails
+    check<1, uint32_t[3][37], uint32_t[3][37]>();
+    check<0, uint8_t[100], uint8_t[100]>();
+    check<2, int64_t[2][2][9], int64_t[2][2][9]>();
+    check<1, uint16_t[2][50], uint32_t[2][50]>();
+    check<1, double[2][20], double[2][20]>();
+    // outer axes, element-wise
+    check<1, uint32_t[3][17][5], uint32_t[3][17][5]>();
+    check<0, uint32_t[7][33], uint64_t[7][33]>();
+    // large, split into parallel tasks
+    check<0, uint32_t[64][8192], uint32_t[64][8192]>();
+    check<1, uint32_t[64][64][128], uint32_t[64][64][128]>();
+    check<2, uint32_t[64][64][128], uint32_t[64][64][128]>();
+
+    // summed-area table, box sums
+    static uint32_t img[480][640], s[480][640], t[480][640];
+    for (size_t i = 0; i != 480; ++i)
+        for (size_t j = 0; j != 640; ++j)
+            img[i][j] = uint32_t((i * 3 + j * 7) % 11);
+    array_nd::summed_area_table(img, array_nd_ref{s});
+    array_nd::summed_area_table(par, img, array_nd_ref{t});
+    assert(array_nd_ref{s} == t);
+    uint32_t box = 0;
+    for (size_t i = 100; i != 200; ++i)
+        for (size_t j = 300; j != 350; ++j)
+            box += img[i][j];
+    assert(s[199][349] - s[99][349] - s[199][299] + s[99][299] == box);
+
+    // in place
+    array_nd::inclusive_scan_axis<1>(img, array_nd_ref{img});
+    array_nd::inclusive_scan_axis<0>(par, img, array_nd_ref{img});
+    assert(array_nd_ref{img} == s);
+}
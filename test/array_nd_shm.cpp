@@ -0,0 +1,121 @@
+#include <cassert>
+#include <cstdint>
+#include <numeric>
+#include <string>
+
+#include <sys/wait.h>
+
+#include "array_nd_shm.hpp"
+
+using array_nd::shm_array;
+using namespace std::chrono_literals;
+
+static_assert(!std::is_copy_constructible_v<shm_array<int[4]>>);
+static_assert(std::is_same_v<
+    decltype(std::declval<shm_array<int const[2][3]>>().ref()),
+    array_nd_ref<int const[2][3]>>);
+
+// create(name) and publish() are for writable arrays only
+template <typename A>
+concept bool creatable = requires { shm_array<A>::create(""); };
+static_assert(creatable<int[4]> && !creatable<int const[4]>);
+
+template <typename E>
+bool throws(auto f)
+{
+    try { f(); } catch (E const&) { return true; }
+    return false;
+}
+
+using table = uint32_t[256][1000];
+
+// reader() child process: waits for the table, checks it, exits 0 if good
+int reader(std::string const& name)
+{
+    try {
+        auto t = shm_array<table const>::open(name, 7, 10s);
+        array_nd_ref<table const> r = t;
+        auto const e = r.elements();
+        for (size_t i = 0; i != e.size(); ++i)
+            if (e[i] != i)
+                return 1;
+        return 0;
+    } catch (...) {
+        return 2;
+    }
+}
+
+int main()
+{
+    std::string const name = "array_nd_shm_test." + std::to_string(::getpid());
+    std::string const other = name + ".other";
+
+    // readers started before the creator wait for the ready flag
+    pid_t const child = ::fork();
+    if (child == 0)
+        ::_exit(reader(name));
+    {
+        auto w = shm_array<table>::create(name, 7);
+        assert(!w.ready() && w.data()[255][999] == 0);
+        assert(reinterpret_cast<uintptr_t>(&w.data()) % 64 == 0);
+        assert(throws<std::system_error>([&]{
+            shm_array<table>::create(name);
+        }));
+        // not published: no wait throws
+        assert(throws<std::runtime_error>([&]{
+            shm_array<table const>::open(name, 7);
+        }));
+        auto const e = w.ref().elements();
+        std::this_thread::sleep_for(20ms);
+        std::iota(e.begin(), e.end(), 0u);
+        w.publish();
+        assert(w.ready());
+    }
+    int status;
+    assert(::waitpid(child, &status, 0) == child);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    // the object outlives its mappings, until unlinked
+    {
+        auto r = shm_array<table const>::open("/" + name, 7);
+        assert(r.data()[2][3] == 2003);
+        // a read-write mapping writes through to the others
+        auto w = shm_array<table>::open(name, 7);
+        w.data()[2][3] = 42;
+        assert(r.data()[2][3] == 42);
+        auto r2 = std::move(r);
+        assert(r2.ref()[2][3] == 42u);
+
+        // version, element type and extents are checked
+        assert(throws<std::runtime_error>([&]{
+            shm_array<table const>::open(name, 8);
+        }));
+        assert(throws<std::runtime_error>([&]{
+            shm_array<int32_t const[256][1000]>::open(name, 7);
+        }));
+        assert(throws<std::runtime_error>([&]{
+            shm_array<uint32_t const[1000][256]>::open(name, 7);
+        }));
+        assert(throws<std::runtime_error>([&]{
+            shm_array<uint32_t const[16]>::open(name, 7);
+        }));
+    }
+    shm_array<table>::unlink(name);
+    assert(throws<std::system_error>([&]{
+        shm_array<table const>::open(name, 7);
+    }));
+    assert(throws<std::system_error>([&]{ shm_array<table>::unlink(name); }));
+
+    // a create that fails to size or map the object removes the name
+    assert(throws<std::system_error>([&]{
+        shm_array<char[1 << 20][1 << 20][1 << 20]>::create(other);
+    }));
+    assert(throws<std::system_error>([&]{ shm_array<table>::unlink(other); }));
+
+    // open times out on a name never created
+    auto const t0 = std::chrono::steady_clock::now();
+    assert(throws<std::system_error>([&]{
+        shm_array<table const>::open(other, 0, 30ms);
+    }));
+    assert(std::chrono::steady_clock::now() - t0 >= 30ms);
+}
@@ -0,0 +1,88 @@
+#include <cassert>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include "array_nd_slice.hpp"
+
+using array_nd::range;
+using array_nd::all;
+
+int main()
+{
+// slice shape and element mapping
+{
+    static int big[8][6][4];
+    auto e = array_nd_ref{big}.elements();
+    std::iota(e.begin(), e.end(), 0);
+
+    auto s = slice(array_nd_ref{big}, range{2,5}, all, 3);
+    static_assert(std::is_same_v<decltype(s), array_nd_slice<int,2>>);
+    assert(s.extent(0) == 3 && s.extent(1) == 6);
+    assert(s.stride(0) == 24 && s.stride(1) == 4);
+    assert(s(0,0) == big[2][0][3] && s(2,5) == big[4][5][3]);
+    assert(s[1][2] == big[3][2][3] && !s.is_contiguous());
+
+    auto t = slice(big, 1, range{0,6,2});   // trailing dim taken whole
+    static_assert(t.rank == 2);
+    assert(t.extent(0) == 3 && t.extent(1) == 4);
+    assert(t(1,2) == big[1][2][2] && t(2,3) == big[1][4][3]);
+
+    int& x = slice(big, 7, 5, 3);           // all indexed: the element
+    assert(&x == &big[7][5][3]);
+
+    auto c = slice(big, range{1,3});        // outer window: contiguous
+    assert(c.is_contiguous() && c.size_flat() == 2*6*4);
+
+    auto ss = slice(s, range{1,3}, range{1,6,2}); // slice of slice
+    assert(ss.extent(1) == 3 && ss(1,2) == big[4][5][3]);
+}
+// fill, copy, compare through strided views
+{
+    static double img[16][16]{};
+    auto tile = slice(img, range{4,8}, range{8,12});
+    tile.fill(1.0);
+    assert(img[4][8] == 1.0 && img[7][11] == 1.0);
+    assert(img[3][8] == 0.0 && img[4][12] == 0.0 && img[8][8] == 0.0);
+
+    double dense[4][4]{};
+    array_nd_ref{dense} = {{1,1,1,1},{1,1,1,1},{1,1,1,1},{1,1,1,1}};
+    assert(tile == slice(dense));
+
+    // copy tile to tile within the same array, and to dense
+    auto other = slice(img, range{0,4}, range{0,4});
+    other.assign(tile);
+    assert(img[3][3] == 1.0 && other == tile);
+
+    double col[16];
+    auto colv = slice(array_nd_ref{col});
+    colv.assign(slice(img, all, 8));       // strided column to dense
+    assert(col[3] == 0.0 && col[4] == 1.0 && col[7] == 1.0);
+
+    slice(img, all, 9).fill(2.0);          // strided fill
+    assert(img[15][9] == 2.0 && img[15][10] == 0.0);
+
+    img[5][9] = 3.0;
+    assert(!(tile == slice(dense)));
+    slice(dense).fill(0);
+    assert(slice(dense) == slice(img, range{12,16}, range{12,16}));
+
+    bool thrown = false;
+    try { other.assign(slice(img, range{0,3}, range{0,4})); }
+    catch (std::length_error&) { thrown = true; }
+    assert(thrown);
+}
+// slice of array_nd_dyn_ref, and constexpr over flat storage
+{
+    std::vector<int> v(5*7);
+    std::iota(v.begin(), v.end(), 0);
+    auto d = array_nd_dyn_ref<int, array_nd::dyn, 7>{v.data(), 5};
+    auto s = slice(d, range{1,5,2}, range{3,7});
+    assert(s.extent(0) == 2 && s(1,3) == 3*7+6);
+
+    static constexpr int buf[12]{0,1,2,3,4,5,6,7,8,9,10,11};
+    constexpr auto cv = array_nd_dyn_ref<int const, 3, 4>{buf};
+    static_assert(slice(cv, all, 2)(2) == 10);
+    static_assert(slice(cv, range{1,3}, range{1,4,2})(1,1) == 11);
+}
+}
@@ -0,0 +1,107 @@
+#include <cassert>
+#include <cmath>
+
+#include "array_nd_matmul.hpp"
+#include "array_nd_small.hpp"
+#include "array_nd_transpose.hpp"
+
+constexpr int m3[3][3] {{2,0,1},{1,3,2},{1,1,2}};
+static_assert(array_nd::determinant(array_nd_ref{m3}) == 6);
+
+constexpr int m5[5][5] {{2,1,0,0,3},{1,2,1,0,0},{0,1,2,1,1},
+                        {0,0,1,2,1},{4,0,0,1,2}};
+static_assert(array_nd::determinant(array_nd_ref{m5}) == -40);
+
+// a zero leading pivot swaps rows; a zero column is singular
+constexpr long p5[5][5] {{0,1,0,0,0},{1,0,0,0,0},{0,0,2,0,0},
+                         {0,0,0,3,0},{0,0,0,0,4}};
+static_assert(array_nd::determinant(array_nd_ref{p5}) == -24);
+constexpr double s6[6][6] {{1,2,0,0,0,0},{2,4,0,0,0,0},{0,0,1,0,0,0},
+                           {0,0,0,1,0,0},{0,0,0,0,1,0},{0,0,0,0,0,1}};
+static_assert(array_nd::determinant(array_nd_ref{s6}) == 0);
+
+// elimination divides exactly, so for N > 4 unsigned T is rejected;
+// the closed forms hold modulo 2^n
+template <typename A>
+concept bool has_determinant = requires (array_nd_ref<A> m) {
+    array_nd::determinant(m);
+};
+static_assert(has_determinant<unsigned[4][4]> && has_determinant<int[5][5]>);
+static_assert(!has_determinant<unsigned[5][5]>
+           && !has_determinant<unsigned const[8][8]>);
+constexpr unsigned u3[3][3] {{1,2,0},{3,4,0},{0,0,1}};
+static_assert(array_nd::determinant(array_nd_ref{u3}) == unsigned(-2));
+
+constexpr bool inverse3()
+{
+    double const m[3][3] {{1,2,0},{0,1,0},{0,0,2}};
+    double r[3][3] {}, p[3][3] {};
+    if (!array_nd::inverse(array_nd_ref{m}, array_nd_ref{r}))
+        return false;
+    array_nd::matmul(array_nd_ref{p}, array_nd_ref{m}, array_nd_ref{r});
+    double const id[3][3] {{1,0,0},{0,1,0},{0,0,1}};
+    return array_nd_ref{p} == id;
+}
+static_assert(inverse3());
+
+constexpr bool inverse5()
+{
+    double const m[5][5] {{0,2,0,0,0},{1,0,0,0,0},{0,0,4,0,0},
+                          {0,0,0,1,1},{0,0,0,0,2}};
+    double r[5][5] {};
+    if (!array_nd::inverse(array_nd_ref{m}, array_nd_ref{r}))
+        return false;
+    return r[0][1] == 1 && r[1][0] == 0.5 && r[2][2] == 0.25
+        && r[3][4] == -0.5 && r[4][4] == 0.5 && r[0][0] == 0;
+}
+static_assert(inverse5());
+
+constexpr bool transposed()
+{
+    int a[2][3] {{1,2,3},{4,5,6}}, b[3][2] {};
+    array_nd::transpose(array_nd_ref{a}, array_nd_ref{b});
+    int s[3][3] {{1,2,3},{4,5,6},{7,8,9}};
+    array_nd::transpose(array_nd_ref{s});
+    return b[2][1] == 6 && b[0][1] == 4 && s[0][2] == 7 && s[2][1] == 6;
+}
+static_assert(transposed());
+
+// check_inverse<N> m inverse(m) == I, to rounding, and det(m) det(m^-1) == 1
+template <size_t N>
+void check_inverse()
+{
+    double m[N][N], r[N][N], p[N][N];
+    for (size_t i = 0; i != N; ++i)
+        for (size_t j = 0; j != N; ++j)
+            m[i][j] = i == j ? 4.0 + double(i) : double((i*3 + j*5) % 7) / 7;
+    assert(array_nd::inverse(array_nd_ref{m}, array_nd_ref{r}));
+    array_nd::matmul(array_nd_ref{p}, array_nd_ref{m}, array_nd_ref{r});
+    for (size_t i = 0; i != N; ++i)
+        for (size_t j = 0; j != N; ++j)
+            assert(std::abs(p[i][j] - (i == j)) < 1e-12);
+    double const d = array_nd::determinant(array_nd_ref{m});
+    assert(std::abs(d * array_nd::determinant(array_nd_ref{r}) - 1) < 1e-12);
+}
+
+int main()
+{
+    check_inverse<2>();
+    check_inverse<3>();
+    check_inverse<4>();
+    check_inverse<5>();
+    check_inverse<8>();
+
+    float s[4][4] {{1,2,0,0},{2,4,0,0},{0,0,1,0},{0,0,0,1}}, r[4][4] {};
+    assert(!array_nd::inverse(array_nd_ref{s}, array_nd_ref{r}));
+    assert(array_nd::determinant(array_nd_ref{s}) == 0);
+    assert(r[0][0] == 0);
+
+    // multiply may alias for small kernels; compare is unrolled
+    float t[4][4] {{0,1,0,0},{1,0,0,0},{0,0,0,1},{0,0,1,0}};
+    float u[4][4];
+    array_nd_ref{u} = t;
+    array_nd::matmul(array_nd_ref{t}, array_nd_ref{t}, array_nd_ref{u});
+    float const id[4][4] {{1,0,0,0},{0,1,0,0},{0,0,1,0},{0,0,0,1}};
+    assert(array_nd_ref{t} == id);
+    assert(!(array_nd_ref{u} == id));
+}
@@ -0,0 +1,64 @@
+#include <cassert>
+#include <cstdint>
+#include <numeric>
+#include <string>
+
+#include "array_nd_transpose.hpp"
+
+// check(M,N) out-of-place then in-place round trips for element type T
+template <typename T, size_t M, size_t N>
+void check()
+{
+    static T a[M][N], b[N][M];
+    auto ae = array_nd_ref{a}.elements();
+    std::iota(ae.begin(), ae.end(), T{});
+
+    array_nd::transpose(array_nd_ref{a}, array_nd_ref{b});
+    for (size_t i = 0; i != M; ++i)
+        for (size_t j = 0; j != N; ++j)
+            assert(b[j][i] == a[i][j]);
+
+    if constexpr (M == N)
+    {
+        array_nd::transpose(array_nd_ref{a});
+        assert(array_nd_ref{a} == b);
+        array_nd::transpose(array_nd_ref{a});
+        array_nd::transpose(array_nd_ref{b});
+        assert(array_nd_ref{a} == b);
+    }
+}
+
+int main()
+{
+    check<float, 1, 1>();
+    check<float, 8, 8>();
+    check<float, 64, 64>();
+    check<float, 301, 301>();
+    check<float, 100, 37>();
+    check<double, 4, 4>();
+    check<double, 129, 129>();
+    check<double, 3, 250>();
+    check<int, 256, 256>();
+    check<int, 517, 130>();
+    check<std::uint16_t, 200, 200>();
+    check<std::int64_t, 33, 65>();
+    check<char, 77, 77>();
+
+    // non-arithmetic element type, scalar tiles
+    std::string s[5][5], t[5][5];
+    for (int i = 0; i != 5; ++i)
+        for (int j = 0; j != 5; ++j)
+            s[i][j] = std::to_string(i*5 + j);
+    array_nd::transpose(array_nd_ref{s}, array_nd_ref{t});
+    array_nd::transpose(array_nd_ref{s});
+    assert(array_nd_ref{s} == t && s[1][3] == "16");
+
+    constexpr int c = []{
+        int m[3][3]{{1,2,3},{4,5,6},{7,8,9}};
+        int n[3][3]{};
+        array_nd::transpose(array_nd_ref{m}, array_nd_ref{n});
+        array_nd::transpose(array_nd_ref{m});
+        return m[0][2] * 10 + n[2][0];
+    }();
+    static_assert(c == 73);
+}
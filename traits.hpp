@@ -162,6 +162,20 @@ using remove_extent_t = typename remove_extent<A>::type;
 template <typename A>
 using remove_all_extents_t = typename remove_all_extents<A>::type;
 
+// remove_axis<A,K> array A with its dimension K removed, e.g.
+// remove_axis_t<int[2][3][4],1> is int[2][4]; cv is kept
+template <typename A, size_t K>
+struct remove_axis
+{
+    using type = typename remove_axis<std::remove_extent_t<A>,K-1>::type
+                                                        [std::extent_v<A>];
+};
+template <typename A>
+struct remove_axis<A,0> : std::remove_extent<A> {};
+
+template <typename A, size_t K>
+using remove_axis_t = typename remove_axis<A,K>::type;
+
 template <typename T>
 inline constexpr
 size_t array_size = std::rank_v<T> ?  